@@ -22,763 +22,795 @@
 #endif
 
 #include <stdio.h>
+#include <string.h>
+#include <signal.h>
 
 #include <glib.h>
 #include <glib/gi18n.h>
+#include <glib-unix.h>
 #include <gtk/gtk.h>
 
 #include <libappindicator/app-indicator.h>
 #include <libnotify/notify.h>
 
-#include <webkit2/webkit2.h>
-#include <json-c/json.h>
-
 #include <dbus/dbus-glib.h>
 #include <dbus/dbus-glib-lowlevel.h>
 
 #include "gooroom-notice-applet.h"
+#include "gooroom-notice-core.h"
+#include "gooroom-notice-log.h"
+#include "gooroom-notice-reclaim.h"
+#include "gooroom-notice-trace.h"
+#include "gooroom-notice-viewer.h"
 
-#define NOTIFICATION_LIMIT       (5)
-#define NOTIFICATION_TEXT_LIMIT  (17)
 #define NOTIFICATION_TIMEOUT     (5000)
 #define NOTIFICATION_SIGNAL      "set_noti"
-#define NOTIFICATION_MSG_ICON    "notice-indicator-msg"
-#define NOTIFICATION_MSG_URGENCY_ICON    "notice-indicator-msg-urgency"
 #define DEFAULT_TRAY_ICON        "notice-indicator-panel"
 #define DEFAULT_NOTICE_TRAY_ICON "notice-indicator-event-panel"
+#define NOTIFICATION_POOL_SIZE   (8)
+#define NOTICE_RECLAIM_DELAY     (60)
+#define NOTICE_LOG_FILE          "/var/tmp/notice.debug"
+#define NOTICE_LOG_FILE_SIZE     (1024)
+#define NOTICE_LOG_FILES         (3)
+#ifdef DEBUG_MSG
+#define NOTICE_LOG_LEVEL         (7)
+#else
+#define NOTICE_LOG_LEVEL         (4)
+#endif
+#define NOTICE_APPLET_BUS_NAME   "kr.gooroom.noticeapplet"
+#define NOTICE_APPLET_STATS_PATH "/kr/gooroom/noticeapplet"
 
-struct _GooroomNoticeAppletPrivate
+/* the desktop side of the applet: notifications, indicator, viewer and agent transport */
+typedef struct
 {
-    GtkWidget    *window;
-    gboolean      img_status;
-
-    GQueue       *queue;
-    GHashTable   *data_list;
-    gint          total;
-
-    gchar    *signing;
-    gchar    *session_id;
-    gchar    *client_id;
-    gchar    *default_domain;
-    gint      disabled_cnt;
-};
+    GooroomNoticeCore *core;
+
+    AppIndicator *indicator;
+    GtkWidget    *menuitem;
+
+    PangoLayout  *title_layout;
+    GQueue       *notification_pool;
+
+    GooroomNoticeReclaim *reclaim;
+
+    gboolean      online;
+    gboolean      prefetch;
+
+    GDBusConnection *session_bus;
+    gchar          **viewer_argv;
+    GSubprocess     *viewer;
+    gboolean         viewer_ready;
+    gchar           *viewer_owner;
+    gchar           *viewer_checking;
+    guint            viewer_watch_id;
+    GQueue          *viewer_pending;
+
+    GCancellable    *cancellable;
+    GDBusConnection *system_bus;
+    gboolean         connecting;
+    guint            agent_watch_id;
+    gchar           *agent_owner;
+    gboolean         proxying;
+    GDBusProxy      *agent_proxy;
+    gulong           agent_signal_id;
+    gchar           *agent_pending;
+}GooroomNoticeApplet;
 
 typedef struct
 {
-    gchar    *url;
-    gchar    *title;
-    gchar    *icon;
-}NoticeData;
+    GooroomNoticeApplet *applet;
+    const gchar *method;
+    GVariant    *parameters;
+    gboolean     retried;
+}ViewerCall;
 
 typedef struct
 {
-    gchar    *client_id;
-    gchar    *session_id;
-    gchar    *signing;
-    gchar    *lang;
-}CookieData;
-
-G_DEFINE_TYPE_WITH_PRIVATE (GooroomNoticeApplet, gooroom_notice_applet, G_TYPE_OBJECT)
+    GooroomNoticeApplet *applet;
+    gchar       *owner;
+}ViewerCheck;
 
-static GtkWidget    *menuitem;
-static AppIndicator *indicator;
 static uint          log_handler = 0;
-static gboolean      is_job = FALSE;
-static gboolean      is_agent = FALSE;
-static gboolean      is_connected = FALSE;
-
-void
-gooroom_log_handler(const gchar *log_domain,
-        GLogLevelFlags log_level,
-        const gchar *message,
-        gpointer user_data)
+
+static gboolean
+on_notice_applet_log_dump (gpointer user_data)
 {
-#ifdef DEBUG_MSG
-    FILE *file = NULL;
-    file = fopen ("/var/tmp/notice.debug", "a");
-    if (file == NULL)
-        return;
+    gooroom_notice_log_dump ();
+    return G_SOURCE_CONTINUE;
+}
 
-    fputs(message, file);
-    fclose (file);
-#endif
+static gboolean
+on_notice_applet_quit (gpointer user_data)
+{
+    /* the session ends the applet with SIGTERM; leave the loop so the core can save */
+    gtk_main_quit ();
+    return G_SOURCE_REMOVE;
 }
 
 static void
-gooroom_tray_icon_change (gpointer user_data)
+gooroom_indicator_set_status (GooroomNoticeIndicatorStatus status, gpointer user_data)
 {
-    g_return_if_fail (user_data != NULL);
+    GooroomNoticeApplet *applet = (GooroomNoticeApplet *)user_data;
 
-    GooroomNoticeApplet *applet = GOOROOM_NOTICE_APPLET (user_data);
-    GooroomNoticeAppletPrivate *priv = applet->priv;
+    /* the indicator is hidden while passive */
+    gooroom_notice_trace_mark ((status == GOOROOM_NOTICE_INDICATOR_PASSIVE) ? "tray-status" : "indicator-shown");
 
-    if (is_connected && is_agent)
-    {
-         if (priv->img_status)
-            app_indicator_set_status (indicator, APP_INDICATOR_STATUS_ATTENTION);
-        else
-            app_indicator_set_status (indicator, APP_INDICATOR_STATUS_ACTIVE);
-    }
-    else
+    switch (status)
     {
-       app_indicator_set_status (indicator, APP_INDICATOR_STATUS_PASSIVE);
+        case GOOROOM_NOTICE_INDICATOR_ATTENTION:
+            app_indicator_set_status (applet->indicator, APP_INDICATOR_STATUS_ATTENTION);
+            break;
+        case GOOROOM_NOTICE_INDICATOR_ACTIVE:
+            app_indicator_set_status (applet->indicator, APP_INDICATOR_STATUS_ACTIVE);
+            break;
+        default:
+            app_indicator_set_status (applet->indicator, APP_INDICATOR_STATUS_PASSIVE);
+            break;
     }
 }
 
-static gchar*
-gooroom_notice_limit_text (gchar* text, gint limit, gint other_cnt)
+static void
+gooroom_agent_signal_cb (GDBusProxy *proxy,
+                         gchar *sender_name,
+                         gchar *signal_name,
+                         GVariant *parameters,
+                         gpointer user_data)
 {
-    gchar *title = g_strstrip (text);
-    glong len = g_utf8_strlen (title, -1);
-
-    if (other_cnt != 0)
-        limit -= 4;
 
-    if (limit < len)
+    g_autofree gchar* signal = g_strdup (NOTIFICATION_SIGNAL);
+    if (g_strcmp0 (signal_name, signal) == 0)
     {
-        g_autofree gchar *t = g_utf8_substring (title, 0, limit);
-        g_autofree gchar *other = g_strdup_printf (_("other %d cases"), other_cnt);
-        title = g_strdup_printf ("%s...", t);
-    }
+        g_return_if_fail (user_data != NULL);
 
-    if (other_cnt != 0)
-    {
-        g_autofree gchar *other = g_strdup_printf (_("other %d cases"), other_cnt);
-        title = g_strdup_printf ("%s %s", title, other);
-    }
+        GooroomNoticeApplet *applet = (GooroomNoticeApplet *)user_data;
 
-    return title;
-}
+        GVariant *v = NULL;
+        g_variant_get (parameters, "(v)", &v);
+        if (!v)
+            return;
 
-static gchar*
-gooroom_notice_other_text (gchar *text, gint other_cnt)
-{
-    gchar *title = g_strstrip (text);
+        const gchar *res = g_variant_get_string (v, NULL);
 
-    if (1 < other_cnt)
-    {
-        g_autofree gchar *other = g_strdup_printf (_("other %d cases"), other_cnt);
-        title = g_strdup_printf ("%s %s", title, other);
+        gchar *bytes = g_strdup_printf ("%" G_GSIZE_FORMAT, strlen (res));
+        gooroom_notice_log_fields (G_LOG_LEVEL_DEBUG, "gooroom_agent_signal_cb", "bytes", bytes, NULL);
+        g_free (bytes);
+
+        gooroom_notice_core_agent_signal (applet->core, res);
+        g_variant_unref (v);
     }
-    return title;
 }
 
-json_object *
-JSON_OBJECT_GET (json_object *root_obj, const char *key)
+static void
+gooroom_application_notice_done_cb (GObject *source_object,
+        GAsyncResult *res,
+        gpointer user_data)
 {
-    if (!root_obj) return NULL;
-
-    json_object *ret_obj = NULL;
+    g_return_if_fail (user_data != NULL);
 
-    json_object_object_get_ex (root_obj, key, &ret_obj);
+    GooroomNoticeApplet *applet = (GooroomNoticeApplet *)user_data;
 
-    return ret_obj;
-}
+    GVariant *variant;
+    gchar *data = NULL;
+    GError *err = NULL;
+    variant = g_dbus_proxy_call_finish (G_DBUS_PROXY (source_object), res, &err);
+    if (err != NULL)
+    {
+        gboolean cancelled = g_error_matches (err, G_IO_ERROR, G_IO_ERROR_CANCELLED);
 
-static gboolean
-is_systemd_service_available (const gchar *service_name)
-{
-    gboolean    ret = TRUE;
-    GVariant   *variant;
-    GDBusProxy *proxy;
-    GError     *error = NULL;
+        g_debug ("gooroom_application_notice_done_cb : %s\n", err->message);
+        g_error_free (err);
 
-    proxy = g_dbus_proxy_new_for_bus_sync (G_BUS_TYPE_SYSTEM,
-            G_DBUS_CALL_FLAGS_NONE, NULL,
-            "org.freedesktop.systemd1",
-            "/org/freedesktop/systemd1",
-            "org.freedesktop.systemd1.Manager",
-            NULL, &error);
+        /* a vanished agent is handled by the name watch */
+        if (!cancelled && applet->agent_proxy == G_DBUS_PROXY (source_object))
+            gooroom_notice_core_agent_failed (applet->core);
+        return;
+    }
 
-    if (!proxy)
+    if (variant)
     {
-        g_error_free (error);
-        return FALSE;
+        GVariant *v = NULL;
+        g_variant_get (variant, "(v)", &v);
+        if (v)
+        {
+            data = g_variant_dup_string (v, NULL);
+            g_variant_unref (v);
+        }
+        g_variant_unref (variant);
     }
 
-    variant = g_dbus_proxy_call_sync (proxy, "GetUnitFileState",
-            g_variant_new ("(s)", service_name),
-            G_DBUS_CALL_FLAGS_NONE, -1, NULL, &error);
-
-    if (!variant)
+    if (data)
     {
-        g_error_free (error);
-        ret = FALSE;
+        gchar *bytes = g_strdup_printf ("%" G_GSIZE_FORMAT, strlen (data));
+        gooroom_notice_log_fields (G_LOG_LEVEL_DEBUG, "gooroom_application_notice_done_cb", "bytes", bytes, NULL);
+        g_free (bytes);
     }
 
-    g_object_unref (proxy);
+    gooroom_notice_core_agent_reply (applet->core, data);
+    g_free (data);
+}
 
-    return ret;
+static void
+gooroom_application_notice_fetch (GooroomNoticeApplet *applet, const gchar *request)
+{
+    g_dbus_proxy_call (applet->agent_proxy,
+            "do_task",
+            g_variant_new ("(s)", request),
+            G_DBUS_CALL_FLAGS_NONE,
+            -1,
+            applet->cancellable,
+            gooroom_application_notice_done_cb,
+            applet);
 }
 
-static gboolean
-is_gooroom_agent_service_available ()
+static void
+gooroom_agent_proxy_drop (GooroomNoticeApplet *applet)
 {
-    gboolean ret = is_systemd_service_available ("kr.gooroom.agent");
+    if (!applet->agent_proxy)
+        return;
 
-    if (ret)
+    if (applet->agent_signal_id)
     {
-        return FALSE;
+        g_signal_handler_disconnect (applet->agent_proxy, applet->agent_signal_id);
+        applet->agent_signal_id = 0;
     }
-    return TRUE;
+
+    g_object_unref (applet->agent_proxy);
+    applet->agent_proxy = NULL;
 }
 
-static GDBusProxy   *agent_proxy = NULL;
+static void gooroom_agent_proxy_create (GooroomNoticeApplet *applet);
 
 static void
-gooroom_agent_signal_cb (GDBusProxy *proxy,
-                         gchar *sender_name,
-                         gchar *signal_name,
-                         GVariant *parameters,
-                         gpointer user_data)
+gooroom_agent_proxy_ready_cb (GObject *source_object, GAsyncResult *res, gpointer user_data)
 {
+    GError *error = NULL;
+    GDBusProxy *proxy = g_dbus_proxy_new_finish (res, &error);
 
-    g_autofree gchar* signal = g_strdup (NOTIFICATION_SIGNAL);
-    if (g_strcmp0 (signal_name, signal) == 0)
+    if (!proxy)
     {
-        g_return_if_fail (user_data != NULL);
+        if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        {
+            g_error_free (error);
+            return;
+        }
 
-        GVariant *v;
-        g_variant_get (parameters, "(v)", &v);
-        gchar *res = g_variant_dup_string (v, NULL);
+        g_debug ("gooroom_agent_proxy_ready_cb : %s\n", error->message);
+        g_error_free (error);
 
-        g_debug ("gooroom_agent_signal_cb : [%s]\n", res);
-        gooroom_application_notice_get_data_from_json (user_data, res, TRUE);
+        ((GooroomNoticeApplet *)user_data)->proxying = FALSE;
+        gooroom_notice_core_agent_failed (((GooroomNoticeApplet *)user_data)->core);
+        return;
+    }
 
-        GooroomNoticeApplet *applet = GOOROOM_NOTICE_APPLET (user_data);
-        GooroomNoticeAppletPrivate *priv = applet->priv;
+    GooroomNoticeApplet *applet = (GooroomNoticeApplet *)user_data;
 
-        guint total = g_queue_get_length (priv->queue);
-        if (0 < total || 0 < priv->disabled_cnt)
-        {
-            priv->img_status = TRUE;
-            gooroom_tray_icon_change (user_data);
+    applet->proxying = FALSE;
 
-            if (!is_job)
-                g_timeout_add (500, (GSourceFunc) gooroom_notice_applet_job,(gpointer)user_data);
-        }
+    /* the owner changed again while the proxy was being created */
+    if (g_strcmp0 (g_dbus_proxy_get_name (proxy), applet->agent_owner) != 0)
+    {
+        g_object_unref (proxy);
+
+        if (applet->agent_owner && applet->agent_pending)
+            gooroom_agent_proxy_create (applet);
+        return;
     }
-}
 
-static GDBusProxy*
-gooroom_agent_proxy_get (void)
-{
-    if (agent_proxy == NULL)
+    gooroom_agent_proxy_drop (applet);
+
+    applet->agent_proxy = proxy;
+    applet->agent_signal_id = g_signal_connect (applet->agent_proxy, "g-signal", G_CALLBACK (gooroom_agent_signal_cb), applet);
+
+    if (applet->agent_pending)
     {
-        agent_proxy = g_dbus_proxy_new_for_bus_sync (G_BUS_TYPE_SYSTEM,
-                      G_DBUS_CALL_FLAGS_NONE,
-                      NULL,
-                      "kr.gooroom.agent",
-                      "/kr/gooroom/agent",
-                      "kr.gooroom.agent",
-                      NULL,
-                      NULL);
+        gooroom_application_notice_fetch (applet, applet->agent_pending);
+        g_clear_pointer (&applet->agent_pending, g_free);
     }
-
-    return agent_proxy;
 }
 
 static void
-gooroom_agent_bind_signal (gpointer data)
+gooroom_agent_proxy_create (GooroomNoticeApplet *applet)
 {
-    agent_proxy = gooroom_agent_proxy_get();
-    if (agent_proxy)
-        g_signal_connect (agent_proxy, "g-signal", G_CALLBACK (gooroom_agent_signal_cb), data);
+    /* one at a time; the request waiting in agent_pending is sent when it is ready */
+    if (applet->proxying)
+        return;
+
+    applet->proxying = TRUE;
+
+    /* bound to the unique name, so every owner gets exactly one handler */
+    g_dbus_proxy_new (applet->system_bus,
+            G_DBUS_PROXY_FLAGS_DO_NOT_LOAD_PROPERTIES | G_DBUS_PROXY_FLAGS_DO_NOT_AUTO_START,
+            NULL,
+            applet->agent_owner,
+            "/kr/gooroom/agent",
+            "kr.gooroom.agent",
+            applet->cancellable,
+            gooroom_agent_proxy_ready_cb,
+            applet);
 }
 
-void
-gooroom_application_notice_get_data_from_json (gpointer user_data, const gchar *data, gboolean urgency)
+static void
+on_agent_name_appeared (GDBusConnection *connection,
+                        const gchar *name,
+                        const gchar *name_owner,
+                        gpointer user_data)
 {
-    g_return_if_fail (user_data != NULL);
-
-    GooroomNoticeApplet *applet = GOOROOM_NOTICE_APPLET (user_data);
-    GooroomNoticeAppletPrivate *priv = applet->priv;
-
-    gchar *ret = NULL;
-
-    enum json_tokener_error jerr = json_tokener_success;
-    json_object *root_obj = json_tokener_parse_verbose (data, &jerr);
+    GooroomNoticeApplet *applet = (GooroomNoticeApplet *)user_data;
 
-    if (jerr != json_tokener_success)
-        goto done;
-
-    json_object *obj1 = NULL, *obj2 = NULL, *obj3 = NULL, *obj4 = NULL, *noti_obj = NULL;
+    if (g_strcmp0 (name_owner, applet->agent_owner) == 0)
+        return;
 
-    if (!urgency)
-    {
-        obj1 = JSON_OBJECT_GET (root_obj, "module");
-        obj2 = JSON_OBJECT_GET (obj1, "task");
-        obj3 = JSON_OBJECT_GET (obj2, "out");
-        obj4 = JSON_OBJECT_GET (obj3, "status");
+    g_debug ("on_agent_name_appeared : %s owned by %s\n", name, name_owner);
 
-        if (!obj4)
-            goto done;
+    gooroom_agent_proxy_drop (applet);
 
-        const char *val = json_object_get_string (obj4);
-        if (val && g_strcmp0 (val, "200") != 0)
-            goto done;
+    g_free (applet->agent_owner);
+    applet->agent_owner = g_strdup (name_owner);
 
-        noti_obj = JSON_OBJECT_GET (obj3, "noti_info");
-        if (!noti_obj)
-            goto done;
-    }
-    else
-    {
-        noti_obj = root_obj;
-    }
+    gooroom_notice_core_agent_appeared (applet->core);
+}
 
-    json_object *enable_view = JSON_OBJECT_GET (noti_obj, "enabled_title_view_notis");
-    json_object *disable_view = JSON_OBJECT_GET (noti_obj, "disabled_title_view_cnt");
-    json_object *signing = JSON_OBJECT_GET (noti_obj, "signing");
-    json_object *client_id = JSON_OBJECT_GET (noti_obj, "client_id");
-    json_object *session_id = JSON_OBJECT_GET (noti_obj, "session_id");
-    json_object *default_domain = JSON_OBJECT_GET (noti_obj, "default_noti_domain");
+static void
+on_agent_name_vanished (GDBusConnection *connection,
+                        const gchar *name,
+                        gpointer user_data)
+{
+    GooroomNoticeApplet *applet = (GooroomNoticeApplet *)user_data;
 
-    if (signing)
-        priv->signing = g_strdup_printf ("%s", json_object_get_string (signing));
+    g_debug ("on_agent_name_vanished : %s\n", name);
 
-    if (client_id)
-        priv->client_id = g_strdup_printf ("%s", json_object_get_string (client_id));
+    gooroom_agent_proxy_drop (applet);
 
-    if (session_id)
-        priv->session_id = g_strdup_printf ("%s", json_object_get_string (session_id));
+    g_free (applet->agent_owner);
+    applet->agent_owner = NULL;
 
-    if (disable_view)
-        priv->disabled_cnt = json_object_get_int (disable_view);
+    gooroom_notice_core_agent_vanished (applet->core);
+}
 
-    if (default_domain)
-        priv->default_domain = g_strdup_printf ("%s", json_object_get_string (default_domain));
+static void
+gooroom_agent_bus_ready_cb (GObject *source_object, GAsyncResult *res, gpointer user_data)
+{
+    GError *error = NULL;
+    GDBusConnection *bus = g_bus_get_finish (res, &error);
 
-    if (enable_view)
+    if (!bus)
     {
-        gint i = 0;
-        gint len = json_object_array_length (enable_view);
-
-        for (i = 0; i < len; i++)
+        if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
         {
-            json_object *v_obj = json_object_array_get_idx (enable_view, i);
-
-            if (!v_obj)
-                continue;
+            g_error_free (error);
+            return;
+        }
 
-            json_object *title = JSON_OBJECT_GET (v_obj, "title");
-            json_object *url = JSON_OBJECT_GET (v_obj, "url");
+        g_debug ("gooroom_agent_bus_ready_cb : %s\n", error->message);
+        g_error_free (error);
 
-            NoticeData *n;
-            n = g_try_new0 (NoticeData, 1);
-            n->title = g_strdup_printf ("%s", json_object_get_string (title));
-            n->url = g_strdup_printf ("%s", json_object_get_string (url));
-            n->icon = urgency ? g_strdup (NOTIFICATION_MSG_URGENCY_ICON) : g_strdup (NOTIFICATION_MSG_ICON);
-            g_queue_push_tail (priv->queue, n);
-        }
+        ((GooroomNoticeApplet *)user_data)->connecting = FALSE;
+        gooroom_notice_core_agent_failed (((GooroomNoticeApplet *)user_data)->core);
+        return;
     }
-    json_object_put (root_obj);
-done:
-    json_object_put (root_obj);
+
+    GooroomNoticeApplet *applet = (GooroomNoticeApplet *)user_data;
+
+    applet->connecting = FALSE;
+    applet->system_bus = bus;
+    applet->agent_watch_id = g_bus_watch_name_on_connection (bus,
+            "kr.gooroom.agent",
+            G_BUS_NAME_WATCHER_FLAGS_AUTO_START,
+            on_agent_name_appeared,
+            on_agent_name_vanished,
+            applet,
+            NULL);
 }
 
+/* connect system bus -> watch agent -> create proxy -> do_task, without blocking */
 static void
-gooroom_application_notice_done_cb (GObject *source_object,
-        GAsyncResult *res,
-        gpointer user_data)
+gooroom_agent_request (const gchar *request, gpointer user_data)
 {
-    g_return_if_fail (user_data != NULL);
+    GooroomNoticeApplet *applet = (GooroomNoticeApplet *)user_data;
 
-    GVariant *variant;
-    gchar *data = NULL;
-    GError *err = NULL;
-    variant = g_dbus_proxy_call_finish (G_DBUS_PROXY (source_object), res, &err);
-    if (err != NULL)
+    if (applet->agent_proxy)
     {
-        const gchar *msg = g_strdup (err->message);
-        g_error_free (err);
-
-        g_timeout_add (500, (GSourceFunc) gooroom_application_notice_update_delay, user_data);
+        gooroom_application_notice_fetch (applet, request);
         return;
     }
 
-    gooroom_agent_bind_signal (user_data);
-    g_error_free (err);
+    /* sent once the proxy is ready */
+    g_free (applet->agent_pending);
+    applet->agent_pending = g_strdup (request);
 
-    if (variant)
+    if (applet->agent_owner)
     {
-        GVariant *v;
-        g_variant_get (variant, "(v)", &v);
-        if (v)
-        {
-            data = g_variant_dup_string (v, NULL);
-            g_variant_unref (v);
-        }
-        g_variant_unref (v);
+        gooroom_agent_proxy_create (applet);
+        return;
     }
 
-    if (data)
-    {
-        g_debug ("gooroom_application_notice_done_cb : agent param [%s]\n", data);
+    if (applet->system_bus || applet->connecting)
+        return;
 
-        gooroom_application_notice_get_data_from_json (user_data, data, FALSE);
+    applet->connecting = TRUE;
+    g_bus_get (G_BUS_TYPE_SYSTEM, applet->cancellable, gooroom_agent_bus_ready_cb, applet);
+}
 
-        GooroomNoticeApplet *applet = GOOROOM_NOTICE_APPLET (user_data);
-        GooroomNoticeAppletPrivate *priv = applet->priv;
-        guint total = g_queue_get_length (priv->queue);
-        if (0 < total || 0 < priv->disabled_cnt)
-        {
-            priv->img_status = TRUE;
+static void gooroom_notice_viewer_send (ViewerCall *call);
 
-            if (!is_job)
-                g_timeout_add (500, (GSourceFunc) gooroom_notice_applet_job,(gpointer)user_data);
-        }
+static void
+gooroom_notice_viewer_call_free (ViewerCall *call)
+{
+    g_variant_unref (call->parameters);
+    g_free (call);
+}
 
-        is_agent = TRUE;
-        gooroom_tray_icon_change (user_data);
-    }
+static void
+gooroom_notice_viewer_drop_pending (GooroomNoticeApplet *applet)
+{
+    ViewerCall *call;
+
+    while ((call = g_queue_pop_head (applet->viewer_pending)))
+        gooroom_notice_viewer_call_free (call);
 }
 
+static void gooroom_notice_viewer_spawn (GooroomNoticeApplet *applet);
+static void gooroom_notice_viewer_watch (GooroomNoticeApplet *applet);
+
 static void
-gooroom_application_notice_update (gpointer user_data)
+gooroom_notice_viewer_exited (GObject *source_object, GAsyncResult *res, gpointer user_data)
 {
-    g_return_if_fail (user_data != NULL);
+    GooroomNoticeApplet *applet = (GooroomNoticeApplet *)user_data;
+    GSubprocess *process = G_SUBPROCESS (source_object);
 
-    agent_proxy = gooroom_agent_proxy_get ();
+    g_subprocess_wait_finish (process, res, NULL);
+    g_debug ("gooroom_notice_viewer_exited : status %d\n", g_subprocess_get_status (process));
 
-    if (agent_proxy)
-    {
-        const gchar *json = "{\"module\":{\"module_name\":\"noti\",\"task\":{\"task_name\":\"get_noti\",\"in\":{\"login_id\":\"%s\"}}}}";
+    if (applet->viewer == process)
+        g_clear_object (&applet->viewer);
 
-        const gchar *user = g_get_user_name();
-#if 0
-        if (g_strcmp0 (user, "lightdm") == 0)
-            user = "";
-#endif
-        gchar *arg = g_strdup_printf (json, user);
-        g_dbus_proxy_call (agent_proxy,
-                "do_task",
-                g_variant_new ("(s)", arg),
-                G_DBUS_CALL_FLAGS_NONE,
-                -1,
-                NULL,
-                gooroom_application_notice_done_cb,
-                user_data);
-
-        g_free (arg);
-    }
-}
+    if (g_queue_is_empty (applet->viewer_pending))
+        return;
 
-gboolean
-gooroom_application_notice_update_delay (gpointer user_data)
-{
-    gooroom_application_notice_update (user_data);
-    return FALSE;
+    /* calls that raced an idle exit go to a new viewer; a viewer that never came up is not retried */
+    if (applet->viewer_ready)
+        gooroom_notice_viewer_spawn (applet);
+    else
+        gooroom_notice_viewer_drop_pending (applet);
 }
 
 static void
-on_notification_closed (NotifyNotification *notification, gpointer user_data)
+gooroom_notice_viewer_spawn (GooroomNoticeApplet *applet)
 {
-    g_return_if_fail (user_data != NULL);
+    GError *error = NULL;
+
+    if (applet->viewer)
+        return;
 
-    GooroomNoticeApplet *applet = GOOROOM_NOTICE_APPLET (user_data);
-    GooroomNoticeAppletPrivate *priv = applet->priv;
-    priv->total--;
+    /* a fresh watch, so that only the new process is reported */
+    gooroom_notice_viewer_watch (applet);
 
-    if (!priv->window)
+    applet->viewer_ready = FALSE;
+    applet->viewer = g_subprocess_newv ((const gchar * const *)applet->viewer_argv, G_SUBPROCESS_FLAGS_NONE, &error);
+    if (!applet->viewer)
     {
-        g_hash_table_remove (priv->data_list, notification);
+        g_warning ("gooroom_notice_viewer_spawn : %s\n", error->message);
+        g_error_free (error);
+
+        gooroom_notice_viewer_drop_pending (applet);
+        return;
     }
-}
 
-static void
-on_notification_popup_cookie_cb (GObject *source_object, GAsyncResult *res, gpointer user_data)
-{
+    g_subprocess_wait_async (applet->viewer, NULL, gooroom_notice_viewer_exited, applet);
 }
 
-static gboolean
-on_notification_popup_closed (GtkWidget *widget, gpointer user_data)
+static void
+gooroom_notice_viewer_done_cb (GObject *source_object, GAsyncResult *res, gpointer user_data)
 {
-    g_return_val_if_fail (user_data != NULL, TRUE);
+    ViewerCall *call = (ViewerCall *)user_data;
+    GooroomNoticeApplet *applet = call->applet;
 
-    GooroomNoticeApplet *applet = GOOROOM_NOTICE_APPLET (user_data);
-    GooroomNoticeAppletPrivate *priv = applet->priv;
-    if (priv->window != NULL)
+    GError *error = NULL;
+    GVariant *result = g_dbus_connection_call_finish (G_DBUS_CONNECTION (source_object), res, &error);
+    if (result)
     {
-        gtk_widget_destroy (priv->window);
-        priv->window = NULL;
+        g_variant_unref (result);
+        gooroom_notice_viewer_call_free (call);
+        return;
     }
 
-    return TRUE;
+    g_debug ("gooroom_notice_viewer_done_cb : %s %s\n", call->method, error->message);
+
+    /* the viewer went away under the call; queue it for the next one */
+    if (!call->retried &&
+        (g_error_matches (error, G_DBUS_ERROR, G_DBUS_ERROR_SERVICE_UNKNOWN) ||
+         g_error_matches (error, G_DBUS_ERROR, G_DBUS_ERROR_NAME_HAS_NO_OWNER) ||
+         g_error_matches (error, G_DBUS_ERROR, G_DBUS_ERROR_NO_REPLY)))
+    {
+        call->retried = TRUE;
+        g_queue_push_tail (applet->viewer_pending, call);
+
+        if (!applet->viewer_owner)
+            gooroom_notice_viewer_spawn (applet);
+    }
+    else
+    {
+        gooroom_notice_viewer_call_free (call);
+    }
+    g_error_free (error);
 }
 
 static void
-on_notification_popup_webview_load_cb (WebKitWebView* view, WebKitLoadEvent load_event, gpointer user_data)
+gooroom_notice_viewer_send (ViewerCall *call)
 {
-    switch (load_event)
+    GooroomNoticeApplet *applet = call->applet;
+
+    if (!applet->session_bus || !applet->viewer_owner)
     {
-        case WEBKIT_LOAD_COMMITTED:
-            {
-                CookieData *cookie = (CookieData *)user_data;
-                if (g_utf8_strlen(cookie->client_id, -1) != 0)
-                {
-                    g_autofree gchar *script = g_strdup_printf ("document.cookie ='CLIENT_ID=%s;1'", cookie->client_id);
-                    webkit_web_view_run_javascript (view, script, NULL, NULL, NULL);
-                }
-
-                if (g_utf8_strlen(cookie->session_id, -1) != 0)
-                {
-                    g_autofree gchar *script = g_strdup_printf ("document.cookie ='SESSION_ID=%s;1'", cookie->session_id);
-                    webkit_web_view_run_javascript (view, script, NULL, NULL, NULL);
-                }
-
-                if (g_utf8_strlen(cookie->signing, -1) != 0)
-                {
-                    g_autofree gchar *script = g_strdup_printf ("document.cookie ='SIGNING=%s;1'", cookie->signing);
-                    webkit_web_view_run_javascript (view, script, NULL, NULL, NULL);
-                }
-
-                if (g_utf8_strlen(cookie->lang, -1) != 0)
-                {
-                    g_autofree gchar *script = g_strdup_printf ("document.cookie ='LANG_CODE=%s;1'", cookie->lang);
-                    webkit_web_view_run_javascript (view, script, NULL, NULL, NULL);
-                    g_free (cookie->lang);
-                }
-
-                break;
-            }
+        g_queue_push_tail (applet->viewer_pending, call);
+        gooroom_notice_viewer_spawn (applet);
+        return;
     }
+
+    /* the checked unique name, never whoever holds the well-known one by now */
+    g_dbus_connection_call (applet->session_bus,
+            applet->viewer_owner,
+            NOTICE_VIEWER_PATH,
+            NOTICE_VIEWER_INTERFACE,
+            call->method,
+            call->parameters,
+            NULL,
+            G_DBUS_CALL_FLAGS_NO_AUTO_START,
+            -1,
+            NULL,
+            gooroom_notice_viewer_done_cb,
+            call);
 }
 
-static gboolean
-on_notification_popup_webview_closed (WebKitWebView* web_view, GtkWidget* window)
+static void
+gooroom_notice_viewer_request (GooroomNoticeApplet *applet, const gchar *method, const gchar *url, const GooroomNoticeSession *session)
 {
-    gtk_widget_destroy (window);
-    return TRUE;
+    ViewerCall *call;
+    call = g_new0 (ViewerCall, 1);
+    call->applet = applet;
+    call->method = method;
+    call->parameters = g_variant_ref_sink (g_variant_new ("(ssss)",
+                url ? url : "",
+                session->client_id ? session->client_id : "",
+                session->session_id ? session->session_id : "",
+                session->signing ? session->signing : ""));
+
+    gooroom_notice_viewer_send (call);
+    gooroom_notice_reclaim_schedule (applet->reclaim);
 }
 
-static gchar*
-gooroom_notice_get_language ()
+/* the process we spawned, or at least the installed viewer binary */
+static gboolean
+gooroom_notice_viewer_trusted (GooroomNoticeApplet *applet, guint32 pid)
 {
-    gchar *lang = NULL;
-
-    PangoLanguage *language = gtk_get_default_language();
-
-    if (language)
+    const gchar *child = applet->viewer ? g_subprocess_get_identifier (applet->viewer) : NULL;
+    if (child)
     {
-        const gchar *plang = pango_language_to_string (language);
-
-        if (g_strcmp0 (plang, "ko-kr") == 0)
-            lang = g_strdup ("ko");
-        else
-            lang = g_strdup ("en");
+        g_autofree gchar *owner = g_strdup_printf ("%u", pid);
+        if (g_strcmp0 (child, owner) == 0)
+            return TRUE;
     }
 
-    return lang;
+    g_autofree gchar *link = g_strdup_printf ("/proc/%u/exe", pid);
+    g_autofree gchar *exe = g_file_read_link (link, NULL);
+
+    return (g_strcmp0 (exe, applet->viewer_argv[0]) == 0);
 }
 
 static void
-gooroom_notice_popup (gchar *url, gpointer user_data)
+gooroom_notice_viewer_check_done (GObject *source_object, GAsyncResult *res, gpointer user_data)
 {
-    GooroomNoticeApplet *applet = GOOROOM_NOTICE_APPLET(user_data);
-    GooroomNoticeAppletPrivate *priv = applet->priv;
-
-    if (priv->window != NULL)
+    ViewerCheck *check = (ViewerCheck *)user_data;
+    GooroomNoticeApplet *applet = check->applet;
+    ViewerCall *call;
+    guint32 pid = 0;
+
+    GError *error = NULL;
+    GVariant *result = g_dbus_connection_call_finish (G_DBUS_CONNECTION (source_object), res, &error);
+    if (result)
     {
-        gtk_widget_destroy (priv->window);
-        priv->window = NULL;
+        g_variant_get (result, "(u)", &pid);
+        g_variant_unref (result);
+    }
+    else
+    {
+        g_debug ("gooroom_notice_viewer_check_done : %s\n", error->message);
+        g_error_free (error);
     }
 
-    if (url == NULL)
-        url = priv->default_domain;
-
-    priv->img_status = FALSE;
-    gooroom_tray_icon_change (user_data);
-
-    GtkWidget *window;
-
-    window = gtk_window_new (GTK_WINDOW_TOPLEVEL);
-    gtk_container_set_border_width (GTK_CONTAINER (window), 5);
-    gtk_window_set_type_hint (GTK_WINDOW (window), GDK_WINDOW_TYPE_HINT_DIALOG);
-    gtk_window_set_skip_taskbar_hint (GTK_WINDOW (window), TRUE);
-    gtk_window_set_position (GTK_WINDOW (window), GTK_WIN_POS_CENTER);
-    gtk_window_set_title (GTK_WINDOW (window), _("Notice"));
-
-    GtkWidget *main_vbox = gtk_box_new (GTK_ORIENTATION_VERTICAL, 5);
-    gtk_container_add (GTK_CONTAINER (window), main_vbox);
-    gtk_widget_show (main_vbox);
-
-    GtkWidget *scroll_window = gtk_scrolled_window_new (NULL, NULL);
-    gtk_scrolled_window_set_policy (GTK_SCROLLED_WINDOW (scroll_window), GTK_POLICY_AUTOMATIC, GTK_POLICY_AUTOMATIC);
-    gtk_box_pack_start (GTK_BOX (main_vbox), scroll_window, TRUE, TRUE, 0);
-    gtk_widget_show (scroll_window);
-
-    WebKitWebView *view = WEBKIT_WEB_VIEW (webkit_web_view_new());
-    gtk_container_add (GTK_CONTAINER (scroll_window), GTK_WIDGET(view));
-
-    gchar* lang = gooroom_notice_get_language();
-
-    CookieData *cookie;
-    cookie = g_try_new0 (CookieData,1);
-    cookie->client_id = priv->client_id;
-    cookie->session_id = priv->session_id;
-    cookie->signing = priv->signing;
-    cookie->lang = lang;
+    /* the name moved on while we asked */
+    if (g_strcmp0 (applet->viewer_checking, check->owner) != 0)
+        goto out;
 
-    g_signal_connect (window, "destroy", G_CALLBACK (on_notification_popup_closed), user_data);
-    g_signal_connect (view, "close", G_CALLBACK (on_notification_popup_webview_closed), window);
-    g_signal_connect (view, "load-changed", G_CALLBACK (on_notification_popup_webview_load_cb), cookie);
+    g_clear_pointer (&applet->viewer_checking, g_free);
 
-    webkit_web_view_load_uri (view, url);
+    if (!pid || !gooroom_notice_viewer_trusted (applet, pid))
+    {
+        g_warning ("gooroom_notice_viewer_check_done : %s (pid %u) is not %s, not sending it the session\n",
+                check->owner, pid, applet->viewer_argv[0]);
+        gooroom_notice_viewer_drop_pending (applet);
+        goto out;
+    }
 
-    WebKitWebContext *context = webkit_web_view_get_context (view);
-    WebKitCookieManager *manager = webkit_web_context_get_cookie_manager (context);
+    applet->viewer_owner = g_strdup (check->owner);
+    applet->viewer_ready = TRUE;
 
-    gtk_widget_grab_focus (GTK_WIDGET (view));
-    gtk_widget_show (GTK_WIDGET(view));
+    while ((call = g_queue_pop_head (applet->viewer_pending)))
+        gooroom_notice_viewer_send (call);
 
-    GtkWidget *hbox = gtk_box_new (GTK_ORIENTATION_HORIZONTAL, 0);
-    gtk_box_pack_end (GTK_BOX (main_vbox), hbox, FALSE, TRUE, 0);
-    gtk_widget_show (hbox);
+out:
+    g_free (check->owner);
+    g_free (check);
+}
 
-    GtkWidget *button = gtk_button_new_with_label (_("Close"));
-    gtk_widget_set_can_focus (button, TRUE);
-    gtk_box_pack_end (GTK_BOX (hbox), button, FALSE, FALSE, 0);
-    g_signal_connect (G_OBJECT (button), "clicked", G_CALLBACK (on_notification_popup_closed), user_data);
-    gtk_widget_show (button);
+/* the calls carry the agent session, so the owner must be our viewer */
+static void
+on_notice_viewer_appeared (GDBusConnection *connection,
+                           const gchar *name,
+                           const gchar *name_owner,
+                           gpointer user_data)
+{
+    GooroomNoticeApplet *applet = (GooroomNoticeApplet *)user_data;
+    ViewerCheck *check;
+
+    g_clear_pointer (&applet->viewer_owner, g_free);
+    g_free (applet->viewer_checking);
+    applet->viewer_checking = g_strdup (name_owner);
+
+    check = g_new0 (ViewerCheck, 1);
+    check->applet = applet;
+    check->owner = g_strdup (name_owner);
+
+    g_dbus_connection_call (connection,
+            "org.freedesktop.DBus",
+            "/org/freedesktop/DBus",
+            "org.freedesktop.DBus",
+            "GetConnectionUnixProcessID",
+            g_variant_new ("(s)", name_owner),
+            G_VARIANT_TYPE ("(u)"),
+            G_DBUS_CALL_FLAGS_NONE,
+            -1,
+            NULL,
+            gooroom_notice_viewer_check_done,
+            check);
+}
 
-    gtk_window_set_default_size (GTK_WINDOW (window), 600, 550);
-    gtk_widget_show_all (window);
+static void
+on_notice_viewer_vanished (GDBusConnection *connection,
+                           const gchar *name,
+                           gpointer user_data)
+{
+    GooroomNoticeApplet *applet = (GooroomNoticeApplet *)user_data;
 
-    priv->window = window;
+    g_clear_pointer (&applet->viewer_owner, g_free);
+    g_clear_pointer (&applet->viewer_checking, g_free);
 
-    g_queue_clear (priv->queue);
-    g_hash_table_remove_all (priv->data_list);
+    if (!g_queue_is_empty (applet->viewer_pending))
+        gooroom_notice_viewer_spawn (applet);
 }
 
 static void
-on_notification_popup_opened (NotifyNotification *notification, char *action, gpointer user_data)
+gooroom_notice_viewer_watch (GooroomNoticeApplet *applet)
 {
-    g_return_if_fail (user_data != NULL);
+    if (applet->viewer_watch_id)
+    {
+        g_bus_unwatch_name (applet->viewer_watch_id);
+        applet->viewer_watch_id = 0;
+    }
 
-    GooroomNoticeApplet *applet = GOOROOM_NOTICE_APPLET(user_data);
-    GooroomNoticeAppletPrivate *priv = applet->priv;
+    g_clear_pointer (&applet->viewer_owner, g_free);
+    g_clear_pointer (&applet->viewer_checking, g_free);
 
-    NoticeData *data;
-    NotifyNotification *key;
-    if (!g_hash_table_lookup_extended (priv->data_list, (gpointer)notification, (gpointer)&key, (gpointer)&data))
+    if (!applet->session_bus)
         return;
 
-    gooroom_notice_popup (data->url, user_data);
+    applet->viewer_watch_id = g_bus_watch_name_on_connection (applet->session_bus,
+            NOTICE_VIEWER_BUS_NAME,
+            G_BUS_NAME_WATCHER_FLAGS_NONE,
+            on_notice_viewer_appeared,
+            on_notice_viewer_vanished,
+            applet,
+            NULL);
 }
 
-static NotifyNotification *
-notification_opened (gpointer user_data, gchar *title, gchar *icon)
+static void
+gooroom_notice_popup (const gchar *url, const GooroomNoticeSession *session, gpointer user_data)
 {
-    g_return_val_if_fail (user_data != NULL, NULL);
-
-    NotifyNotification *notification;
-    notify_init (PACKAGE_NAME);
-    notification = notify_notification_new (title, "", icon);
-    notify_notification_add_action (notification, "default", _("detail view"), (NotifyActionCallback)on_notification_popup_opened, user_data, NULL);
-    notify_notification_set_urgency (notification, NOTIFY_URGENCY_NORMAL);
-    notify_notification_set_timeout (notification, NOTIFICATION_TIMEOUT);
-    notify_notification_show (notification, NULL);
+    GooroomNoticeApplet *applet = (GooroomNoticeApplet *)user_data;
 
-    return notification;
+    gooroom_notice_viewer_request (applet, "Open", url, session);
 }
 
 static void
-on_notice_applet_hash_key_destroy (gpointer user_data)
+gooroom_notice_prefetch (const gchar *url, const GooroomNoticeSession *session, gpointer user_data)
 {
-    g_return_if_fail (user_data != NULL);
+    GooroomNoticeApplet *applet = (GooroomNoticeApplet *)user_data;
 
-    NotifyNotification *n = (NotifyNotification*)user_data;
-    notify_notification_close (n, NULL);
+    if (!url || !applet->prefetch || !applet->online)
+        return;
+
+    gooroom_notice_viewer_request (applet, "Prefetch", url, session);
 }
 
 static void
-on_notice_applet_hash_value_destroy (gpointer user_data)
+on_notification_popup_opened (NotifyNotification *notification, char *action, gpointer user_data)
 {
     g_return_if_fail (user_data != NULL);
 
-    NoticeData *n = (NoticeData *)user_data;
-
-    if (n->title)
-        g_free (n->title);
-
-    if (n->url)
-        g_free (n->url);
+    GooroomNoticeApplet *applet = (GooroomNoticeApplet *)user_data;
 
-    if (n->icon)
-        g_free (n->icon);
+    gooroom_notice_core_notification_activated (applet->core, notification);
 }
 
+/*
+ * A notification goes back to the pool only once the server reports it
+ * closed, so a late "closed" can never hit a notification that already
+ * carries the next notice.
+ */
 static void
-on_notice_applet_menuitem_activate_cb (GtkWidget *menuitem, gpointer user_data)
+on_notification_closed (NotifyNotification *notification, gpointer user_data)
 {
     g_return_if_fail (user_data != NULL);
 
-    gooroom_notice_popup (NULL, user_data);
+    GooroomNoticeApplet *applet = (GooroomNoticeApplet *)user_data;
+
+    gooroom_notice_core_notification_closed (applet->core, notification);
+    gooroom_notice_reclaim_schedule (applet->reclaim);
+
+    if (g_queue_get_length (applet->notification_pool) < NOTIFICATION_POOL_SIZE)
+        g_queue_push_head (applet->notification_pool, notification);
+    else
+        g_object_unref (notification);
 }
 
-gboolean
-gooroom_notice_applet_job (gpointer user_data)
+static gpointer
+notification_opened (const gchar *title, const gchar *icon, GooroomNoticeUrgency urgency, gpointer user_data)
 {
-    g_return_val_if_fail (user_data != NULL, FALSE);
-
-    GooroomNoticeApplet *applet = GOOROOM_NOTICE_APPLET(user_data);
-    GooroomNoticeAppletPrivate *priv = applet->priv;
+    g_return_val_if_fail (user_data != NULL, NULL);
 
-    is_job = TRUE;
+    GooroomNoticeApplet *applet = (GooroomNoticeApplet *)user_data;
 
-    if (NOTIFICATION_LIMIT <= priv->total)
+    NotifyNotification *notification = g_queue_pop_head (applet->notification_pool);
+    if (notification)
     {
-        guint total = g_queue_get_length (priv->queue);
-        if (0 == total)
-            is_job = FALSE;
-
-        return is_job;
+        /* keeps the action and the server id; show() sends it as replaces_id */
+        notify_notification_update (notification, title, "", icon);
     }
-
-    NoticeData *n;
-    while ((n = g_queue_pop_head (priv->queue)))
+    else
     {
-        if (!n)
-            continue;
+        notification = notify_notification_new (title, "", icon);
+        notify_notification_add_action (notification, "default", _("detail view"), (NotifyActionCallback)on_notification_popup_opened, user_data, NULL);
+        notify_notification_set_timeout (notification, NOTIFICATION_TIMEOUT);
 
-        priv->total++;
-
-        gchar *title = NULL;
-        title = gooroom_notice_limit_text (n->title, NOTIFICATION_TEXT_LIMIT, 0);
-
-        NotifyNotification *notification =  notification_opened (user_data, title, n->icon);
-        g_hash_table_insert (priv->data_list, notification, n);
         g_signal_connect (G_OBJECT (notification), "closed", G_CALLBACK (on_notification_closed), user_data);
-
-        return is_job;
     }
 
-    guint total = g_queue_get_length (priv->queue);
+    notify_notification_set_urgency (notification,
+            (urgency == GOOROOM_NOTICE_URGENCY_CRITICAL) ? NOTIFY_URGENCY_CRITICAL : NOTIFY_URGENCY_NORMAL);
+    notify_notification_show (notification, NULL);
+    gooroom_notice_trace_mark ("notification-shown");
+    gooroom_notice_reclaim_schedule (applet->reclaim);
 
-    if (0 != total)
-        return is_job;
+    return notification;
+}
 
-    if (0 != priv->disabled_cnt)
-    {
-        priv->total++;
+static void
+notification_close (gpointer notification, gpointer user_data)
+{
+    g_return_if_fail (notification != NULL);
 
-        gchar *tmp = g_strdup (_("Notice"));
-        gchar *no_title = gooroom_notice_other_text (tmp, priv->disabled_cnt);
+    NotifyNotification *n = (NotifyNotification*)notification;
+    notify_notification_close (n, NULL);
+}
 
-        NoticeData *n;
-        n = g_try_new0 (NoticeData, 1);
-        n->title = no_title;
-        n->url = g_strdup_printf ("%s", priv->default_domain);
-        n->icon = g_strdup (NOTIFICATION_MSG_ICON);
+static void
+on_notice_applet_menuitem_activate_cb (GtkWidget *menuitem, gpointer user_data)
+{
+    g_return_if_fail (user_data != NULL);
 
-        NotifyNotification *notification = notification_opened (user_data, no_title, n->icon);
-        g_hash_table_insert (priv->data_list, notification, n);
-        g_signal_connect (G_OBJECT (notification), "closed", G_CALLBACK (on_notification_closed), user_data);
-    }
+    GooroomNoticeApplet *applet = (GooroomNoticeApplet *)user_data;
 
-    is_job = FALSE;
-    return is_job;
+    gooroom_notice_core_open (applet->core, NULL);
 }
 
 static void
@@ -786,138 +818,215 @@ gooroom_notice_applet_network_changed (GNetworkMonitor *monitor,
                                        gboolean network_available,
                                        gpointer user_data)
 {
-    if (is_connected == network_available)
-        return;
-
-    is_connected = network_available;
-    gooroom_tray_icon_change (user_data);
+    GooroomNoticeApplet *applet = (GooroomNoticeApplet *)user_data;
 
-    if (is_connected)
-    {
-        if (agent_proxy == NULL && !is_agent)
-            g_timeout_add (500, (GSourceFunc)gooroom_application_notice_update_delay, user_data);
-    }
+    applet->online = network_available;
+    gooroom_notice_core_network_changed (applet->core, network_available);
 }
 
-static void
-gooroom_notice_applet_finalize (GObject *object)
+/* notification servers render the summary in the bold variant of the desktop font */
+static PangoLayout *
+gooroom_notice_title_layout_get (GooroomNoticeApplet *applet)
 {
-    G_OBJECT_CLASS (gooroom_notice_applet_parent_class)->finalize (object);
+    if (applet->title_layout)
+        return applet->title_layout;
 
-    GooroomNoticeApplet *applet = GOOROOM_NOTICE_APPLET(object);
-    GooroomNoticeAppletPrivate *priv = applet->priv;
+    gchar *font_name = NULL;
+    g_object_get (gtk_settings_get_default (), "gtk-font-name", &font_name, NULL);
 
-    if (priv->signing)
-        g_free (priv->signing);
+    PangoFontDescription *desc = pango_font_description_from_string (font_name ? font_name : "Sans 10");
+    pango_font_description_set_weight (desc, PANGO_WEIGHT_BOLD);
 
-    if (priv->session_id)
-        g_free (priv->session_id);
+    PangoContext *context = gdk_pango_context_get ();
+    applet->title_layout = pango_layout_new (context);
+    pango_layout_set_font_description (applet->title_layout, desc);
 
-    if (priv->client_id)
-        g_free (priv->client_id);
+    g_object_unref (context);
+    pango_font_description_free (desc);
+    g_free (font_name);
 
-    if (priv->default_domain)
-        g_free (priv->default_domain);
+    return applet->title_layout;
+}
 
-    if (priv->window != NULL)
-        gtk_widget_destroy (priv->window);
+static gint
+gooroom_notice_text_width (const gchar *text, gsize len, gpointer user_data)
+{
+    GooroomNoticeApplet *applet = (GooroomNoticeApplet *)user_data;
+    PangoLayout *layout = gooroom_notice_title_layout_get (applet);
+    gint width = 0;
 
-    if (priv->queue)
-    {
-        g_queue_clear (priv->queue);
-        g_queue_free (priv->queue);
-        priv->queue = NULL;
-    }
+    pango_layout_set_text (layout, text, len);
+    pango_layout_get_pixel_size (layout, &width, NULL);
 
-    if (priv->data_list)
-    {
-        g_hash_table_destroy (priv->data_list);
-        priv->data_list = NULL;
-    }
+    return width;
+}
 
-    if (agent_proxy)
-        g_object_unref (agent_proxy);
+static void
+gooroom_notice_applet_reclaim (gpointer user_data)
+{
+    GooroomNoticeApplet *applet = (GooroomNoticeApplet *)user_data;
+    NotifyNotification *notification;
 
-    if (log_handler != 0)
-    {
-        g_log_remove_handler (NULL, log_handler);
-        log_handler = 0;
-    }
+    gooroom_notice_core_reclaim (applet->core);
+
+    /* rebuilt on the next notice */
+    while ((notification = g_queue_pop_head (applet->notification_pool)))
+        g_object_unref (notification);
+
+    g_clear_object (&applet->title_layout);
 }
 
 static void
-gooroom_notice_applet_init (GooroomNoticeApplet *applet)
+on_notice_applet_bus_acquired (GDBusConnection *connection, const gchar *name, gpointer user_data)
 {
-    GooroomNoticeAppletPrivate *priv;
-    priv = applet->priv = gooroom_notice_applet_get_instance_private (applet);
-    priv->window     = NULL;
-    priv->img_status = FALSE;
+    GooroomNoticeApplet *applet = (GooroomNoticeApplet *)user_data;
+    GError *error = NULL;
 
-    priv->total      = 0;
-    priv->queue      = g_queue_new ();
-    priv->data_list  = g_hash_table_new_full (g_direct_hash, g_direct_equal, (GDestroyNotify)on_notice_applet_hash_key_destroy, (GDestroyNotify)on_notice_applet_hash_value_destroy);
+    if (!gooroom_notice_stats_export (gooroom_notice_core_get_stats (applet->core), connection, NOTICE_APPLET_STATS_PATH, &error))
+    {
+        g_debug ("on_notice_applet_bus_acquired : %s\n", error->message);
+        g_error_free (error);
+    }
 
-    priv->signing    = NULL;
-    priv->session_id = NULL;
-    priv->client_id  = NULL;
-    priv->default_domain = NULL;
-    priv->disabled_cnt = 0;
+    g_clear_object (&applet->session_bus);
+    applet->session_bus = g_object_ref (connection);
+    gooroom_notice_viewer_watch (applet);
 }
 
-static void
-gooroom_notice_applet_class_init (GooroomNoticeAppletClass *class)
+/* the viewer reads no configuration of its own */
+static gchar **
+gooroom_notice_viewer_argv_new (GooroomNoticeApplet *applet)
 {
-    GObjectClass *object_class;
-    object_class = G_OBJECT_CLASS (class);
-    object_class->finalize = gooroom_notice_applet_finalize;
+    GooroomNoticeCore *core = applet->core;
+    GPtrArray *argv = g_ptr_array_new ();
+
+    g_ptr_array_add (argv, g_build_filename (LIBEXECDIR, NOTICE_VIEWER_PROGRAM, NULL));
+    g_ptr_array_add (argv, g_strdup_printf ("--idle-timeout=%d",
+                gooroom_notice_core_config_get_int (core, "ViewerIdleTimeout", NOTICE_VIEWER_IDLE_TIMEOUT)));
+    g_ptr_array_add (argv, g_strdup_printf ("--disk-cache=%d",
+                gooroom_notice_core_config_get_int (core, "DiskCacheSize", NOTICE_VIEWER_DISK_CACHE_SIZE)));
+    g_ptr_array_add (argv, g_strdup_printf ("--prefetch-concurrency=%d",
+                gooroom_notice_core_config_get_int (core, "PrefetchConcurrency", NOTICE_VIEWER_PREFETCH_CONCURRENCY)));
+    g_ptr_array_add (argv, g_strdup_printf ("--prefetch-budget=%d",
+                gooroom_notice_core_config_get_int (core, "PrefetchBudget", NOTICE_VIEWER_PREFETCH_BUDGET)));
+    g_ptr_array_add (argv, g_strdup_printf ("--offline-cache=%d",
+                gooroom_notice_core_config_get_int (core, "OfflineCacheSize", NOTICE_VIEWER_OFFLINE_CACHE_SIZE)));
+    g_ptr_array_add (argv, g_strdup_printf ("--reclaim-delay=%d",
+                gooroom_notice_core_config_get_int (core, "ReclaimDelay", NOTICE_RECLAIM_DELAY)));
+    g_ptr_array_add (argv, g_strdup_printf ("--log-level=%d",
+                gooroom_notice_core_config_get_int (core, "LogLevel", NOTICE_LOG_LEVEL)));
+    g_ptr_array_add (argv, NULL);
+
+    return (gchar **)g_ptr_array_free (argv, FALSE);
 }
 
+static const GooroomNoticeBackend notice_applet_backend =
+{
+    notification_opened,
+    notification_close,
+    gooroom_indicator_set_status,
+    gooroom_notice_popup,
+    gooroom_agent_request,
+    gooroom_notice_text_width,
+    gooroom_notice_prefetch
+};
+
 int
 main (int argc, char **argv)
 {
+    gooroom_notice_trace_mark ("main");
+
     bindtextdomain (GETTEXT_PACKAGE, LOCALEDIR);
     bind_textdomain_codeset (GETTEXT_PACKAGE, "UTF-8");
     textdomain (GETTEXT_PACKAGE);
 
     gtk_init (&argc, &argv);
+    gooroom_notice_trace_mark ("gtk-init");
+    notify_init (PACKAGE_NAME);
 
-    agent_proxy = NULL;
-
-    GooroomNoticeApplet *applet = g_object_new (TYPE_GOOROOM_NOTICE_APPLET,
-            0,
-            "kr.gooroom.noticeapplet",
-            "flags",
-            G_APPLICATION_HANDLES_OPEN,
-            NULL);
+    GooroomNoticeApplet *applet = g_new0 (GooroomNoticeApplet, 1);
+    applet->notification_pool = g_queue_new ();
+    applet->viewer_pending = g_queue_new ();
+    applet->cancellable = g_cancellable_new ();
 
-    indicator = app_indicator_new ("gooroom-notice-applet",
+    applet->indicator = app_indicator_new ("gooroom-notice-applet",
             DEFAULT_TRAY_ICON,
             APP_INDICATOR_CATEGORY_APPLICATION_STATUS);
 
-    app_indicator_set_title(indicator, "gooroom-notice-applet");
-    app_indicator_set_attention_icon (indicator, DEFAULT_NOTICE_TRAY_ICON);
-    app_indicator_set_status(indicator, APP_INDICATOR_STATUS_PASSIVE);
+    app_indicator_set_title(applet->indicator, "gooroom-notice-applet");
+    app_indicator_set_attention_icon (applet->indicator, DEFAULT_NOTICE_TRAY_ICON);
+    app_indicator_set_status(applet->indicator, APP_INDICATOR_STATUS_PASSIVE);
+    gooroom_notice_trace_mark ("indicator-new");
+
+    applet->core = gooroom_notice_core_new (&notice_applet_backend, applet);
+
+    applet->viewer_argv = gooroom_notice_viewer_argv_new (applet);
+    applet->reclaim = gooroom_notice_reclaim_new (
+            MAX (gooroom_notice_core_config_get_int (applet->core, "ReclaimDelay", NOTICE_RECLAIM_DELAY), 0),
+            gooroom_notice_core_get_stats (applet->core),
+            gooroom_notice_applet_reclaim, applet);
+    applet->prefetch = (0 < gooroom_notice_core_config_get_int (applet->core, "PrefetchConcurrency", NOTICE_VIEWER_PREFETCH_CONCURRENCY));
 
     GtkWidget *menu = gtk_menu_new ();
-    menuitem = gtk_menu_item_new_with_label ("dummy");
-    gtk_menu_shell_append (GTK_MENU_SHELL (menu), menuitem);
-    app_indicator_set_menu (indicator, GTK_MENU (menu));
+    applet->menuitem = gtk_menu_item_new_with_label ("dummy");
+    gtk_menu_shell_append (GTK_MENU_SHELL (menu), applet->menuitem);
+    app_indicator_set_menu (applet->indicator, GTK_MENU (menu));
 
     gtk_widget_show_all (menu);
+    gooroom_notice_trace_mark ("menu");
 
-    g_signal_connect (menuitem, "activate", G_CALLBACK (on_notice_applet_menuitem_activate_cb), applet);
+    g_signal_connect (applet->menuitem, "activate", G_CALLBACK (on_notice_applet_menuitem_activate_cb), applet);
+
+    gooroom_notice_log_open (NOTICE_LOG_FILE,
+            gooroom_notice_core_config_get_int (applet->core, "LogLevel", NOTICE_LOG_LEVEL),
+            (gsize)MAX (gooroom_notice_core_config_get_int (applet->core, "LogFileSize", NOTICE_LOG_FILE_SIZE), 0) * 1024,
+            MAX (gooroom_notice_core_config_get_int (applet->core, "LogFiles", NOTICE_LOG_FILES), 0));
 
     log_handler = g_log_set_handler (NULL,
             G_LOG_LEVEL_MASK | G_LOG_FLAG_FATAL | G_LOG_FLAG_RECURSION,
-            gooroom_log_handler, NULL);
+            gooroom_notice_log_handler, NULL);
+
+    /* kill -USR1 writes the in-memory history next to the log */
+    g_unix_signal_add (SIGUSR1, on_notice_applet_log_dump, NULL);
+    g_unix_signal_add (SIGTERM, on_notice_applet_quit, NULL);
+    g_unix_signal_add (SIGINT, on_notice_applet_quit, NULL);
+    g_unix_signal_add (SIGHUP, on_notice_applet_quit, NULL);
 
     GNetworkMonitor *monitor = g_network_monitor_get_default();
     g_signal_connect (monitor, "network-changed", G_CALLBACK (gooroom_notice_applet_network_changed), applet);
 
-    is_connected = g_network_monitor_get_network_available (monitor);
+    applet->online = g_network_monitor_get_network_available (monitor);
+    gooroom_notice_trace_mark ("network-query");
+    gooroom_notice_core_set_connected (applet->core, applet->online);
 
-    if (is_connected)
-        g_timeout_add (500, (GSourceFunc) gooroom_application_notice_update_delay, (gpointer)applet);
+    /* the first pass returns what startup and the initial fetch left behind */
+    gooroom_notice_reclaim_schedule (applet->reclaim);
 
+    g_bus_own_name (G_BUS_TYPE_SESSION,
+            NOTICE_APPLET_BUS_NAME,
+            G_BUS_NAME_OWNER_FLAGS_NONE,
+            on_notice_applet_bus_acquired,
+            NULL,
+            NULL,
+            applet,
+            NULL);
+
+    gooroom_notice_trace_mark ("main-loop");
     gtk_main();
+
+    if (applet->viewer_watch_id)
+        g_bus_unwatch_name (applet->viewer_watch_id);
+
+    if (applet->agent_watch_id)
+        g_bus_unwatch_name (applet->agent_watch_id);
+
+    /* writes a pending or dirty snapshot before the process exits */
+    g_object_unref (applet->core);
+    gooroom_notice_reclaim_free (applet->reclaim);
+
+    notify_uninit ();
+
+    /* the flush thread writes what is still buffered, then the log closes */
+    g_log_remove_handler (NULL, log_handler);
+    gooroom_notice_log_close ();
 }
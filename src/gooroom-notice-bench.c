@@ -0,0 +1,210 @@
+/*
+ * Copyright (c) 2018 - 2019 Gooroom <gooroom@gooroom.kr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include "gooroom-notice-core.h"
+#include "gooroom-notice-memory-backend.h"
+
+extern void *__libc_malloc (size_t size);
+extern void *__libc_calloc (size_t nmemb, size_t size);
+extern void *__libc_realloc (void *ptr, size_t size);
+
+static gint      payloads = 200;
+static gint      notices = 50;
+static gdouble   rate = 0;
+static gchar    *mode = NULL;
+
+static gsize     bench_allocs = 0;
+static gboolean  bench_counting = FALSE;
+
+/* count heap allocations made by the code under measurement */
+void *
+malloc (size_t size)
+{
+    if (bench_counting)
+        __atomic_fetch_add (&bench_allocs, 1, __ATOMIC_RELAXED);
+    return __libc_malloc (size);
+}
+
+void *
+calloc (size_t nmemb, size_t size)
+{
+    if (bench_counting)
+        __atomic_fetch_add (&bench_allocs, 1, __ATOMIC_RELAXED);
+    return __libc_calloc (nmemb, size);
+}
+
+void *
+realloc (void *ptr, size_t size)
+{
+    if (bench_counting && !ptr)
+        __atomic_fetch_add (&bench_allocs, 1, __ATOMIC_RELAXED);
+    return __libc_realloc (ptr, size);
+}
+
+static GOptionEntry entries[] =
+{
+    { "payloads", 'n', 0, G_OPTION_ARG_INT, &payloads, "Number of payloads to ingest", "N" },
+    { "notices", 'm', 0, G_OPTION_ARG_INT, &notices, "Notices per payload", "M" },
+    { "rate", 'r', 0, G_OPTION_ARG_DOUBLE, &rate, "Payloads per second, 0 for back to back", "R" },
+    { "mode", 0, 0, G_OPTION_ARG_STRING, &mode, "set_noti or get_noti", "MODE" },
+    { NULL }
+};
+
+static gchar*
+bench_payload (gboolean reply, guint seq, gint count)
+{
+    GString *str = g_string_sized_new (count * 160 + 256);
+    gint i;
+
+    if (reply)
+        g_string_append (str, "{\"module\":{\"module_name\":\"noti\",\"task\":{\"task_name\":\"get_noti\","
+                              "\"out\":{\"status\":\"200\",\"noti_info\":");
+
+    g_string_append (str, "{\"enabled_title_view_notis\":[");
+    for (i = 0; i < count; i++)
+    {
+        g_string_append_printf (str,
+                "%s{\"noti_id\":\"%u-%d\",\"title\":\"\\uacf5\\uc9c0 %u-%d system maintenance notice\","
+                "\"url\":\"https://notice.example/view?id=%u-%d\"}",
+                i ? "," : "", seq, i, seq, i, seq, i);
+    }
+    g_string_append (str, "],\"disabled_title_view_cnt\":0,\"signing\":\"c2lnbmluZw==\","
+                          "\"client_id\":\"bench-client\",\"session_id\":\"bench-session\","
+                          "\"default_noti_domain\":\"https://notice.example\"}");
+
+    if (reply)
+        g_string_append (str, "}}}}");
+
+    return g_string_free (str, FALSE);
+}
+
+static gint
+bench_compare (gconstpointer a, gconstpointer b)
+{
+    gint64 x = *(const gint64 *)a, y = *(const gint64 *)b;
+    return (x > y) - (x < y);
+}
+
+static gint64
+bench_percentile (GArray *samples, gdouble p)
+{
+    if (samples->len == 0)
+        return 0;
+
+    guint idx = (guint)(p * (samples->len - 1) + 0.5);
+    return g_array_index (samples, gint64, idx);
+}
+
+int
+main (int argc, char **argv)
+{
+    GError *error = NULL;
+    GOptionContext *context = g_option_context_new ("- notice ingest and dispatch benchmark");
+    g_option_context_add_main_entries (context, entries, NULL);
+    if (!g_option_context_parse (context, &argc, &argv, &error))
+    {
+        g_printerr ("%s\n", error->message);
+        return 1;
+    }
+    g_option_context_free (context);
+
+    gboolean reply = (g_strcmp0 (mode, "get_noti") == 0);
+
+    /* keep the run away from the user's snapshot */
+    g_autofree gchar *cache = g_dir_make_tmp ("gooroom-notice-bench-XXXXXX", NULL);
+    g_setenv ("XDG_CACHE_HOME", cache, TRUE);
+
+    GooroomNoticeMemoryBackend *backend = gooroom_notice_memory_backend_new ();
+    GooroomNoticeCore *core = gooroom_notice_memory_backend_attach (backend);
+
+    GArray *latency = g_array_sized_new (FALSE, FALSE, sizeof (gint64), payloads);
+    gint64 busy = 0;
+    gsize allocs = 0;
+    gint64 start = g_get_monotonic_time ();
+    guint seq;
+
+    for (seq = 0; seq < (guint)payloads; seq++)
+    {
+        g_autofree gchar *data = bench_payload (reply, seq, notices);
+
+        if (0 < rate)
+        {
+            gint64 due = start + (gint64)(seq * G_USEC_PER_SEC / rate);
+            gint64 now = g_get_monotonic_time ();
+            if (now < due)
+                g_usleep (due - now);
+        }
+
+        gsize before = bench_allocs;
+        bench_counting = TRUE;
+        gint64 t0 = g_get_monotonic_time ();
+
+        gooroom_application_notice_get_data_from_json (core, data, !reply);
+        while (gooroom_notice_core_job (core))
+            gooroom_notice_memory_backend_close_all (backend);
+        gooroom_notice_memory_backend_close_all (backend);
+
+        gint64 t1 = g_get_monotonic_time ();
+        bench_counting = FALSE;
+        allocs += bench_allocs - before;
+
+        busy += t1 - t0;
+        g_array_append_val (latency, (gint64){ t1 - t0 });
+    }
+
+    gint64 elapsed = g_get_monotonic_time () - start;
+    g_array_sort (latency, bench_compare);
+
+    struct rusage usage;
+    getrusage (RUSAGE_SELF, &usage);
+
+    guint total = (guint)payloads * (guint)notices;
+
+    printf ("{\"mode\":\"%s\",\"payloads\":%d,\"notices_per_payload\":%d,\"rate\":%g,"
+            "\"notices\":%u,\"shown\":%u,\"elapsed_us\":%" G_GINT64_FORMAT ",\"busy_us\":%" G_GINT64_FORMAT ","
+            "\"throughput_notices_per_s\":%.1f,"
+            "\"latency_us\":{\"p50\":%" G_GINT64_FORMAT ",\"p90\":%" G_GINT64_FORMAT ","
+            "\"p99\":%" G_GINT64_FORMAT ",\"max\":%" G_GINT64_FORMAT "},"
+            "\"allocs_per_notice\":%.2f,\"peak_rss_kb\":%ld}\n",
+            reply ? "get_noti" : "set_noti", payloads, notices, rate,
+            total, gooroom_notice_memory_backend_shown (backend), elapsed, busy,
+            busy ? total * (gdouble)G_USEC_PER_SEC / busy : 0.0,
+            bench_percentile (latency, 0.50), bench_percentile (latency, 0.90),
+            bench_percentile (latency, 0.99), bench_percentile (latency, 1.0),
+            total ? (gdouble)allocs / total : 0.0,
+            usage.ru_maxrss);
+
+    g_array_free (latency, TRUE);
+    g_object_unref (core);
+    gooroom_notice_memory_backend_free (backend);
+    g_free (mode);
+
+    return 0;
+}
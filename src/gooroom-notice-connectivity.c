@@ -0,0 +1,250 @@
+/*
+ * Copyright (c) 2018 - 2019 Gooroom <gooroom@gooroom.kr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <glib.h>
+#include <gio/gio.h>
+
+#include "gooroom-notice-connectivity.h"
+
+#define NOTICE_CONNECTIVITY_PROBE_MIN  (5)
+#define NOTICE_CONNECTIVITY_PROBE_MAX  (300)
+
+struct _GooroomNoticeConnectivity
+{
+    guint          up_delay;
+    guint          down_delay;
+
+    gboolean       available;
+    gboolean       connected;
+
+    gchar         *probe_url;
+    GCancellable  *probe;
+    guint          probe_interval;
+    guint          timer_id;
+
+    GooroomNoticeConnectivityFunc  func;
+    gpointer                       func_data;
+};
+
+typedef struct
+{
+    GooroomNoticeConnectivity *connectivity;
+    GCancellable              *cancellable;
+}ConnectivityProbe;
+
+static void gooroom_notice_connectivity_probe (GooroomNoticeConnectivity *connectivity);
+
+static void
+gooroom_notice_connectivity_commit (GooroomNoticeConnectivity *connectivity, gboolean connected)
+{
+    if (connectivity->connected == connected)
+        return;
+
+    g_debug ("gooroom_notice_connectivity_commit : %s\n", connected ? "connected" : "disconnected");
+
+    connectivity->connected = connected;
+    connectivity->func (connected, connectivity->func_data);
+}
+
+/* drops the pending timer and any probe in flight */
+static void
+gooroom_notice_connectivity_stop (GooroomNoticeConnectivity *connectivity)
+{
+    if (connectivity->timer_id)
+    {
+        g_source_remove (connectivity->timer_id);
+        connectivity->timer_id = 0;
+    }
+
+    if (connectivity->probe)
+    {
+        g_cancellable_cancel (connectivity->probe);
+        g_clear_object (&connectivity->probe);
+    }
+}
+
+static gboolean
+gooroom_notice_connectivity_retry_cb (gpointer user_data)
+{
+    GooroomNoticeConnectivity *connectivity = (GooroomNoticeConnectivity *)user_data;
+
+    connectivity->timer_id = 0;
+    gooroom_notice_connectivity_probe (connectivity);
+
+    return FALSE;
+}
+
+static void
+gooroom_notice_connectivity_probe_done (GObject *source_object, GAsyncResult *res, gpointer user_data)
+{
+    ConnectivityProbe *probe = (ConnectivityProbe *)user_data;
+    GooroomNoticeConnectivity *connectivity = probe->connectivity;
+
+    GError *error = NULL;
+    gboolean reachable = g_network_monitor_can_reach_finish (G_NETWORK_MONITOR (source_object), res, &error);
+
+    /* superseded, @connectivity may be gone */
+    gboolean cancelled = g_cancellable_is_cancelled (probe->cancellable);
+    g_object_unref (probe->cancellable);
+    g_free (probe);
+
+    if (cancelled)
+    {
+        g_clear_error (&error);
+        return;
+    }
+
+    g_clear_object (&connectivity->probe);
+
+    if (reachable)
+    {
+        connectivity->probe_interval = NOTICE_CONNECTIVITY_PROBE_MIN;
+        gooroom_notice_connectivity_commit (connectivity, TRUE);
+        return;
+    }
+
+    g_debug ("gooroom_notice_connectivity_probe_done : %s, retry in %u s\n", error->message, connectivity->probe_interval);
+    g_error_free (error);
+
+    connectivity->timer_id = g_timeout_add_seconds (connectivity->probe_interval, gooroom_notice_connectivity_retry_cb, connectivity);
+    connectivity->probe_interval = MIN (connectivity->probe_interval * 2, NOTICE_CONNECTIVITY_PROBE_MAX);
+}
+
+static void
+gooroom_notice_connectivity_probe (GooroomNoticeConnectivity *connectivity)
+{
+    GSocketConnectable *address = NULL;
+
+    if (connectivity->probe_url)
+    {
+        g_autofree gchar *scheme = g_uri_parse_scheme (connectivity->probe_url);
+        guint16 port = (g_ascii_strcasecmp (scheme ? scheme : "", "https") == 0) ? 443 : 80;
+
+        address = g_network_address_parse_uri (connectivity->probe_url, port, NULL);
+    }
+
+    if (!address)
+    {
+        gooroom_notice_connectivity_commit (connectivity, TRUE);
+        return;
+    }
+
+    ConnectivityProbe *probe;
+    probe = g_new0 (ConnectivityProbe, 1);
+    probe->connectivity = connectivity;
+    probe->cancellable = g_cancellable_new ();
+    connectivity->probe = g_object_ref (probe->cancellable);
+
+    g_network_monitor_can_reach_async (g_network_monitor_get_default (), address, probe->cancellable,
+                                       gooroom_notice_connectivity_probe_done, probe);
+    g_object_unref (address);
+}
+
+static gboolean
+gooroom_notice_connectivity_settled_cb (gpointer user_data)
+{
+    GooroomNoticeConnectivity *connectivity = (GooroomNoticeConnectivity *)user_data;
+
+    connectivity->timer_id = 0;
+
+    if (connectivity->available)
+    {
+        connectivity->probe_interval = NOTICE_CONNECTIVITY_PROBE_MIN;
+        gooroom_notice_connectivity_probe (connectivity);
+    }
+    else
+    {
+        gooroom_notice_connectivity_commit (connectivity, FALSE);
+    }
+
+    return FALSE;
+}
+
+GooroomNoticeConnectivity *
+gooroom_notice_connectivity_new (guint up_delay, guint down_delay, GooroomNoticeConnectivityFunc func, gpointer user_data)
+{
+    g_return_val_if_fail (func != NULL, NULL);
+
+    GooroomNoticeConnectivity *connectivity;
+    connectivity = g_new0 (GooroomNoticeConnectivity, 1);
+    connectivity->up_delay = up_delay;
+    connectivity->down_delay = down_delay;
+    connectivity->probe_interval = NOTICE_CONNECTIVITY_PROBE_MIN;
+    connectivity->func = func;
+    connectivity->func_data = user_data;
+
+    return connectivity;
+}
+
+void
+gooroom_notice_connectivity_free (GooroomNoticeConnectivity *connectivity)
+{
+    if (!connectivity)
+        return;
+
+    gooroom_notice_connectivity_stop (connectivity);
+    g_free (connectivity->probe_url);
+    g_free (connectivity);
+}
+
+void
+gooroom_notice_connectivity_set_available (GooroomNoticeConnectivity *connectivity, gboolean available)
+{
+    if (connectivity->available == available && (connectivity->timer_id || connectivity->probe))
+        return;
+
+    connectivity->available = available;
+    gooroom_notice_connectivity_stop (connectivity);
+
+    /* back where it was before the flap */
+    if (available == connectivity->connected)
+        return;
+
+    connectivity->timer_id = g_timeout_add (available ? connectivity->up_delay : connectivity->down_delay,
+                                            gooroom_notice_connectivity_settled_cb, connectivity);
+}
+
+void
+gooroom_notice_connectivity_reset (GooroomNoticeConnectivity *connectivity, gboolean connected)
+{
+    gooroom_notice_connectivity_stop (connectivity);
+
+    connectivity->available = connected;
+    connectivity->connected = connected;
+}
+
+void
+gooroom_notice_connectivity_set_probe (GooroomNoticeConnectivity *connectivity, const gchar *url)
+{
+    if (g_strcmp0 (connectivity->probe_url, url) == 0)
+        return;
+
+    g_free (connectivity->probe_url);
+    connectivity->probe_url = g_strdup (url);
+}
+
+gboolean
+gooroom_notice_connectivity_get_connected (GooroomNoticeConnectivity *connectivity)
+{
+    return connectivity->connected;
+}
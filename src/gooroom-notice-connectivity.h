@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2018-2019 Gooroom <gooroom@gooroom.kr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#ifndef __GOOROOM_NOTICE_CONNECTIVITY_H__
+#define __GOOROOM_NOTICE_CONNECTIVITY_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef void (*GooroomNoticeConnectivityFunc) (gboolean connected, gpointer user_data);
+
+typedef struct _GooroomNoticeConnectivity GooroomNoticeConnectivity;
+
+/*
+ * Turns raw network availability into a debounced connected state.
+ * Network has to stay up for @up_delay ms before the notice server is
+ * probed and @func is told about the connection, and has to stay down
+ * for @down_delay ms before the loss is reported; flaps in between go
+ * unnoticed. A probe that fails is retried with backoff for as long as
+ * the network stays up. @func runs once per change of the state.
+ */
+GooroomNoticeConnectivity *gooroom_notice_connectivity_new (guint up_delay,
+                                                            guint down_delay,
+                                                            GooroomNoticeConnectivityFunc func,
+                                                            gpointer user_data);
+void gooroom_notice_connectivity_free (GooroomNoticeConnectivity *connectivity);
+
+/* feeds a raw availability change */
+void gooroom_notice_connectivity_set_available (GooroomNoticeConnectivity *connectivity, gboolean available);
+
+/* sets the state outright, dropping any pending transition; @func is not called */
+void gooroom_notice_connectivity_reset (GooroomNoticeConnectivity *connectivity, gboolean connected);
+
+/*
+ * url whose host has to be reachable before connecting; NULL skips the
+ * probe. The probe is g_network_monitor_can_reach_async(): it resolves
+ * the host and checks that a route to it exists, on the url's port or
+ * the scheme's default. It does not talk to the server, so a server
+ * that is down but routable still counts as reachable.
+ */
+void gooroom_notice_connectivity_set_probe (GooroomNoticeConnectivity *connectivity, const gchar *url);
+
+gboolean gooroom_notice_connectivity_get_connected (GooroomNoticeConnectivity *connectivity);
+
+G_END_DECLS
+
+#endif /* __GOOROOM_NOTICE_CONNECTIVITY_H__*/
@@ -0,0 +1,1220 @@
+/*
+ * Copyright (c) 2018 - 2019 Gooroom <gooroom@gooroom.kr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <glib.h>
+#include <glib/gi18n.h>
+#include <gio/gio.h>
+
+#include "gooroom-notice-core.h"
+#include "gooroom-notice-data.h"
+#include "gooroom-notice-json.h"
+#include "gooroom-notice-index.h"
+#include "gooroom-notice-snapshot.h"
+#include "gooroom-notice-stats.h"
+#include "gooroom-notice-layout.h"
+#include "gooroom-notice-queue.h"
+#include "gooroom-notice-connectivity.h"
+#include "gooroom-notice-trace.h"
+
+#define NOTIFICATION_LIMIT       (5)
+#define NOTIFICATION_TEXT_LIMIT  (17)
+#define NOTIFICATION_TITLE_WIDTH (240)
+#define NOTIFICATION_MSG_ICON    "notice-indicator-msg"
+#define NOTIFICATION_MSG_URGENCY_ICON    "notice-indicator-msg-urgency"
+#define NOTICE_INDEX_SIZE        (1024)
+#define NOTICE_DISPATCH_INTERVAL (500)
+#define NOTICE_DISPATCH_BURST    (1)
+#define NOTICE_DIGEST_THRESHOLD  (20)
+#define NOTICE_URGENCY_AGING     (10000)
+#define NOTICE_AGENT_RETRY_MIN   (500)
+#define NOTICE_AGENT_RETRY_MAX   (60000)
+#define NOTICE_CONNECTIVITY_UP_DELAY   (2000)
+#define NOTICE_CONNECTIVITY_DOWN_DELAY (5000)
+#define NOTICE_SNAPSHOT_DELAY    (2000)
+#define NOTICE_SNAPSHOT_FILE     "notice.snapshot"
+
+/* every key and its default is listed in data/gooroom-notice-applet.conf */
+#define NOTICE_CONFIG_FILE       SYSCONFDIR"/gooroom/gooroom-notice-applet.conf"
+#define NOTICE_CONFIG_GROUP      "Notice"
+
+struct _GooroomNoticeCorePrivate
+{
+    GooroomNoticeBackend  backend;
+    gpointer              backend_data;
+
+    GKeyFile     *config;
+    GCancellable *cancellable;
+    GooroomNoticeStats *stats;
+    GooroomNoticeLayout *layout;
+    gint64        agent_call_start;
+
+    guint         retry_id;
+    guint         retry_delay;
+    gboolean      img_status;
+    gboolean      is_job;
+    gboolean      is_agent;
+    gboolean      is_connected;
+    guint         update_id;
+    gboolean      probe;
+    GooroomNoticeConnectivity *connectivity;
+
+    NoticeQueue  *queue;
+    GHashTable   *data_list;
+    GooroomNoticeJsonDecoder *json_decoder;
+    GooroomNoticeIndex       *index;
+    GHashTable               *unread;
+
+    gchar        *snapshot_path;
+    guint         snapshot_id;
+    gboolean      snapshot_writing;
+    gboolean      snapshot_dirty;
+    gboolean      restored;
+    gint          total;
+
+    guint         dispatch_interval;
+    gint          dispatch_burst;
+    guint         digest_threshold;
+    guint         digest_cnt;
+    gint          notification_limit;
+
+    gchar    *signing;
+    gchar    *session_id;
+    gchar    *client_id;
+    gchar    *default_domain;
+    gchar    *cursor;
+    gint      disabled_cnt;
+};
+
+G_DEFINE_TYPE_WITH_PRIVATE (GooroomNoticeCore, gooroom_notice_core, G_TYPE_OBJECT)
+
+static void gooroom_notice_core_job_start (gpointer user_data);
+static gint gooroom_notice_core_dispatch_critical (gpointer user_data);
+
+static guint
+gooroom_notice_core_pending (GooroomNoticeCorePrivate *priv)
+{
+    return gooroom_notice_queue_length (priv->queue) + priv->digest_cnt;
+}
+
+static void
+gooroom_tray_icon_change (gpointer user_data)
+{
+    g_return_if_fail (user_data != NULL);
+
+    GooroomNoticeCore *core = GOOROOM_NOTICE_CORE (user_data);
+    GooroomNoticeCorePrivate *priv = core->priv;
+
+    GooroomNoticeIndicatorStatus status = GOOROOM_NOTICE_INDICATOR_PASSIVE;
+
+    if (priv->is_connected && (priv->is_agent || priv->restored))
+        status = priv->img_status ? GOOROOM_NOTICE_INDICATOR_ATTENTION : GOOROOM_NOTICE_INDICATOR_ACTIVE;
+
+    priv->backend.indicator_set_status (status, priv->backend_data);
+}
+
+gint
+gooroom_notice_core_config_get_int (GooroomNoticeCore *core, const gchar *key, gint default_value)
+{
+    GooroomNoticeCorePrivate *priv = core->priv;
+
+    GError *error = NULL;
+    gint value = g_key_file_get_integer (priv->config, NOTICE_CONFIG_GROUP, key, &error);
+
+    if (error)
+    {
+        g_error_free (error);
+        return default_value;
+    }
+
+    return value;
+}
+
+static void
+gooroom_notice_config_load (gpointer user_data)
+{
+    GooroomNoticeCore *core = GOOROOM_NOTICE_CORE (user_data);
+    GooroomNoticeCorePrivate *priv = core->priv;
+
+    priv->config = g_key_file_new ();
+    g_key_file_load_from_file (priv->config, NOTICE_CONFIG_FILE, G_KEY_FILE_NONE, NULL);
+}
+
+/* closes every notification on screen and forgets them */
+static void
+gooroom_notice_core_close_all (GooroomNoticeCorePrivate *priv)
+{
+    GHashTableIter iter;
+    gpointer notification;
+
+    g_hash_table_iter_init (&iter, priv->data_list);
+    while (g_hash_table_iter_next (&iter, &notification, NULL))
+        priv->backend.notification_close (notification, priv->backend_data);
+
+    g_hash_table_remove_all (priv->data_list);
+}
+
+static void
+gooroom_notice_snapshot_add_seen (gpointer key, gpointer builder)
+{
+    g_variant_builder_add ((GVariantBuilder *)builder, "s", (const gchar *)key);
+}
+
+static GVariant*
+gooroom_notice_snapshot_build (GooroomNoticeCorePrivate *priv)
+{
+    GVariantBuilder meta, unread, seen;
+    GHashTableIter iter;
+    gpointer key, value;
+
+    /* no credentials: the cache directory gets backed up and copied, and the agent resends them */
+    g_variant_builder_init (&meta, G_VARIANT_TYPE ("a{ss}"));
+    if (priv->default_domain)
+        g_variant_builder_add (&meta, "{ss}", "default_noti_domain", priv->default_domain);
+    if (priv->cursor)
+        g_variant_builder_add (&meta, "{ss}", "cursor", priv->cursor);
+
+    g_variant_builder_init (&unread, G_VARIANT_TYPE ("a(sssb)"));
+    g_hash_table_iter_init (&iter, priv->unread);
+    while (g_hash_table_iter_next (&iter, &key, &value))
+    {
+        NoticeData *n = (NoticeData *)value;
+        g_variant_builder_add (&unread, "(sssb)",
+                (gchar *)key,
+                n->title ? n->title : "",
+                n->url ? n->url : "",
+                g_strcmp0 (n->icon, NOTIFICATION_MSG_URGENCY_ICON) == 0);
+    }
+
+    g_variant_builder_init (&seen, G_VARIANT_TYPE ("as"));
+    gooroom_notice_index_foreach (priv->index, (GFunc) gooroom_notice_snapshot_add_seen, &seen);
+
+    return g_variant_new (NOTICE_SNAPSHOT_TYPE, NOTICE_SNAPSHOT_VERSION, &meta, priv->disabled_cnt, &unread, &seen);
+}
+
+static void gooroom_notice_snapshot_schedule (gpointer user_data);
+
+static void
+gooroom_notice_snapshot_write_done (GObject *source_object, GAsyncResult *res, gpointer user_data)
+{
+    GError *error = NULL;
+
+    if (!gooroom_notice_snapshot_write_finish (res, &error))
+    {
+        gboolean cancelled = g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+
+        g_debug ("gooroom_notice_snapshot_write_done : %s\n", error->message);
+        g_error_free (error);
+
+        if (cancelled)
+            return;
+    }
+
+    GooroomNoticeCore *core = GOOROOM_NOTICE_CORE (user_data);
+    GooroomNoticeCorePrivate *priv = core->priv;
+
+    priv->snapshot_writing = FALSE;
+
+    if (priv->snapshot_dirty)
+    {
+        priv->snapshot_dirty = FALSE;
+        gooroom_notice_snapshot_schedule (user_data);
+    }
+}
+
+static gboolean
+gooroom_notice_snapshot_flush (gpointer user_data)
+{
+    GooroomNoticeCore *core = GOOROOM_NOTICE_CORE (user_data);
+    GooroomNoticeCorePrivate *priv = core->priv;
+
+    priv->snapshot_id = 0;
+
+    /* one write in flight; changes made meanwhile go into the next one */
+    if (priv->snapshot_writing)
+    {
+        priv->snapshot_dirty = TRUE;
+        return FALSE;
+    }
+
+    priv->snapshot_writing = TRUE;
+    gooroom_notice_snapshot_write_async (priv->snapshot_path,
+            gooroom_notice_snapshot_build (priv),
+            priv->cancellable,
+            gooroom_notice_snapshot_write_done,
+            user_data);
+
+    return FALSE;
+}
+
+static void
+gooroom_notice_snapshot_schedule (gpointer user_data)
+{
+    GooroomNoticeCore *core = GOOROOM_NOTICE_CORE (user_data);
+    GooroomNoticeCorePrivate *priv = core->priv;
+
+    if (priv->snapshot_id)
+        return;
+
+    priv->snapshot_id = g_timeout_add (NOTICE_SNAPSHOT_DELAY, (GSourceFunc) gooroom_notice_snapshot_flush, user_data);
+}
+
+static gchar**
+gooroom_notice_field_target (GooroomNoticeCorePrivate *priv, NoticeJsonField field)
+{
+    switch (field)
+    {
+        case NOTICE_JSON_FIELD_SIGNING:
+            return &priv->signing;
+        case NOTICE_JSON_FIELD_CLIENT_ID:
+            return &priv->client_id;
+        case NOTICE_JSON_FIELD_SESSION_ID:
+            return &priv->session_id;
+        case NOTICE_JSON_FIELD_DEFAULT_DOMAIN:
+            return &priv->default_domain;
+        case NOTICE_JSON_FIELD_CURSOR:
+            return &priv->cursor;
+        case NOTICE_JSON_FIELD_SYNC:
+            break;
+    }
+    return NULL;
+}
+
+static void
+gooroom_notice_snapshot_restore (gpointer user_data)
+{
+    GooroomNoticeCore *core = GOOROOM_NOTICE_CORE (user_data);
+    GooroomNoticeCorePrivate *priv = core->priv;
+
+    GVariant *snapshot = gooroom_notice_snapshot_read (priv->snapshot_path);
+    if (!snapshot)
+        return;
+
+    guint32 version;
+    gint disabled_cnt;
+    GVariantIter *meta, *unread, *seen;
+    const gchar *key, *value, *title, *url;
+    gboolean urgent;
+    gboolean credentials = FALSE;
+
+    g_variant_get (snapshot, NOTICE_SNAPSHOT_TYPE, &version, &meta, &disabled_cnt, &unread, &seen);
+
+    while (g_variant_iter_next (meta, "{&s&s}", &key, &value))
+    {
+        gchar **target = NULL;
+
+        /* older snapshots kept the session credentials; they are not restored */
+        if (g_strcmp0 (key, "signing") == 0 ||
+            g_strcmp0 (key, "client_id") == 0 ||
+            g_strcmp0 (key, "session_id") == 0)
+            credentials = TRUE;
+        else if (g_strcmp0 (key, "default_noti_domain") == 0)
+            target = gooroom_notice_field_target (priv, NOTICE_JSON_FIELD_DEFAULT_DOMAIN);
+        else if (g_strcmp0 (key, "cursor") == 0)
+            target = gooroom_notice_field_target (priv, NOTICE_JSON_FIELD_CURSOR);
+
+        if (target)
+        {
+            g_free (*target);
+            *target = g_strdup (value);
+        }
+    }
+
+    while (g_variant_iter_next (unread, "(&s&s&sb)", &key, &title, &url, &urgent))
+    {
+        NoticeData *n = gooroom_notice_data_new (NULL, key, title, *url ? url : NULL,
+                urgent ? NOTIFICATION_MSG_URGENCY_ICON : NOTIFICATION_MSG_ICON);
+        g_hash_table_replace (priv->unread, n->key, n);
+    }
+
+    while (g_variant_iter_next (seen, "&s", &key))
+        gooroom_notice_index_add (priv->index, key);
+
+    g_variant_iter_free (meta);
+    g_variant_iter_free (unread);
+    g_variant_iter_free (seen);
+    g_variant_unref (snapshot);
+
+    priv->disabled_cnt = disabled_cnt;
+    priv->restored = TRUE;
+
+    /* rewrites the file without them */
+    if (credentials)
+        gooroom_notice_snapshot_schedule (core);
+
+    if (0 < g_hash_table_size (priv->unread) || 0 < priv->disabled_cnt)
+        priv->img_status = TRUE;
+
+    g_debug ("gooroom_notice_snapshot_restore : %u unread notices\n", g_hash_table_size (priv->unread));
+}
+
+typedef struct
+{
+    GooroomNoticeCorePrivate   *priv;
+    gboolean                    urgency;
+    GHashTable                 *seen;
+    gboolean                    changed;
+    NoticeBatch                *batch;
+    gint64                      received;
+    gchar                      *cursor;
+    gboolean                    delta;
+}NoticeJsonContext;
+
+static void
+on_notice_json_notice (const gchar *id, const gchar *title, const gchar *url, gpointer user_data)
+{
+    NoticeJsonContext *ctx = (NoticeJsonContext *)user_data;
+    const gchar *key = id ? id : url;
+
+    if (key && ctx->seen)
+        g_hash_table_add (ctx->seen, g_strdup (key));
+
+    gooroom_notice_stats_count (ctx->priv->stats, GOOROOM_NOTICE_COUNTER_NOTICES_RECEIVED, 1);
+
+    /* the agent re-announces notices; keep only the first of each */
+    if (!gooroom_notice_index_add (ctx->priv->index, key))
+    {
+        NoticeData *old = key ? g_hash_table_lookup (ctx->priv->unread, key) : NULL;
+
+        /* an edited notice is not announced again, only its unread entry follows */
+        if (old && (g_strcmp0 (old->title, title) != 0 || g_strcmp0 (old->url, url) != 0))
+        {
+            NoticeData *n = gooroom_notice_data_new (NULL, key, title, url, old->icon);
+            g_hash_table_replace (ctx->priv->unread, n->key, n);
+            ctx->changed = TRUE;
+            return;
+        }
+
+        g_debug ("on_notice_json_notice : drop duplicate [%s]\n", key);
+        gooroom_notice_stats_count (ctx->priv->stats, GOOROOM_NOTICE_COUNTER_NOTICES_DROPPED, 1);
+        return;
+    }
+
+    if (!ctx->batch)
+        ctx->batch = gooroom_notice_batch_new ();
+
+    const gchar *icon = ctx->urgency ? NOTIFICATION_MSG_URGENCY_ICON : NOTIFICATION_MSG_ICON;
+    NoticeData *n = gooroom_notice_data_new (ctx->batch, key, title, url, icon);
+    n->received = ctx->received;
+
+    /* unread entries outlive the payload, so they do not share its batch */
+    if (n->key)
+    {
+        NoticeData *entry = gooroom_notice_data_copy (n);
+        g_hash_table_replace (ctx->priv->unread, entry->key, entry);
+    }
+
+    gooroom_notice_queue_push (ctx->priv->queue, n, ctx->urgency ? GOOROOM_NOTICE_URGENCY_CRITICAL : GOOROOM_NOTICE_URGENCY_NORMAL);
+
+    ctx->changed = TRUE;
+}
+
+/* the cursor goes back into the request JSON verbatim */
+static gboolean
+gooroom_notice_cursor_valid (const gchar *cursor)
+{
+    const gchar *p;
+
+    for (p = cursor; *p; p++)
+    {
+        if (!g_ascii_isgraph (*p) || *p == '"' || *p == '\\')
+            return FALSE;
+    }
+    return p != cursor;
+}
+
+static void
+on_notice_json_field (NoticeJsonField field, const gchar *value, gpointer user_data)
+{
+    NoticeJsonContext *ctx = (NoticeJsonContext *)user_data;
+
+    /* only get_noti replies move the cursor, and only once they are fully read */
+    if (field == NOTICE_JSON_FIELD_CURSOR)
+    {
+        if (!ctx->urgency && gooroom_notice_cursor_valid (value))
+        {
+            g_free (ctx->cursor);
+            ctx->cursor = g_strdup (value);
+        }
+        return;
+    }
+
+    if (field == NOTICE_JSON_FIELD_SYNC)
+    {
+        ctx->delta = (g_strcmp0 (value, "delta") == 0);
+        return;
+    }
+
+    gchar **target = gooroom_notice_field_target (ctx->priv, field);
+
+    if (!target || g_strcmp0 (*target, value) == 0)
+        return;
+
+    g_free (*target);
+    *target = g_strdup (value);
+    ctx->changed = TRUE;
+}
+
+static void
+on_notice_json_disabled_cnt (gint cnt, gpointer user_data)
+{
+    NoticeJsonContext *ctx = (NoticeJsonContext *)user_data;
+
+    if (ctx->priv->disabled_cnt == cnt)
+        return;
+
+    ctx->priv->disabled_cnt = cnt;
+    ctx->changed = TRUE;
+}
+
+static void
+on_notice_json_retracted (const gchar *id, gpointer user_data)
+{
+    NoticeJsonContext *ctx = (NoticeJsonContext *)user_data;
+
+    if (g_hash_table_remove (ctx->priv->unread, id))
+        ctx->changed = TRUE;
+}
+
+static const NoticeJsonHandler notice_json_handler =
+{
+    on_notice_json_notice,
+    on_notice_json_field,
+    on_notice_json_disabled_cnt,
+    on_notice_json_retracted
+};
+
+static gboolean
+on_notice_unread_retracted (gpointer key, gpointer value, gpointer user_data)
+{
+    return !g_hash_table_contains ((GHashTable *)user_data, key);
+}
+
+void
+gooroom_application_notice_get_data_from_json (gpointer user_data, const gchar *data, gboolean urgency)
+{
+    g_return_if_fail (user_data != NULL);
+
+    GooroomNoticeCore *core = GOOROOM_NOTICE_CORE (user_data);
+    GooroomNoticeCorePrivate *priv = core->priv;
+
+    NoticeJsonContext ctx = { priv, urgency, NULL, FALSE, NULL, g_get_monotonic_time (), NULL, FALSE };
+
+    /* a full get_noti reply is the whole list, so it also tells what was retracted */
+    if (!urgency)
+        ctx.seen = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+    gint64 start = g_get_monotonic_time ();
+
+    /* set_noti carries noti_info directly, the do_task reply wraps it */
+    gboolean parsed = gooroom_notice_json_decoder_parse (priv->json_decoder, data, !urgency, &notice_json_handler, &ctx);
+
+    gooroom_notice_stats_observe (priv->stats, GOOROOM_NOTICE_HISTOGRAM_PARSE, g_get_monotonic_time () - start);
+    gooroom_notice_stats_count (priv->stats, GOOROOM_NOTICE_COUNTER_PAYLOADS, 1);
+
+    if (!parsed)
+    {
+        gooroom_notice_stats_count (priv->stats, GOOROOM_NOTICE_COUNTER_PAYLOAD_ERRORS, 1);
+        g_debug ("gooroom_application_notice_get_data_from_json : no notice in payload\n");
+    }
+    else if (!urgency)
+    {
+        /* a delta names its retractions itself */
+        if (!ctx.delta && g_hash_table_foreach_remove (priv->unread, on_notice_unread_retracted, ctx.seen))
+            ctx.changed = TRUE;
+
+        /* no cursor in the reply means the agent does not do deltas */
+        if (g_strcmp0 (priv->cursor, ctx.cursor) != 0)
+        {
+            g_free (priv->cursor);
+            priv->cursor = g_steal_pointer (&ctx.cursor);
+            ctx.changed = TRUE;
+        }
+    }
+
+    if (ctx.seen)
+        g_hash_table_destroy (ctx.seen);
+
+    g_free (ctx.cursor);
+
+    gooroom_notice_batch_unref (ctx.batch);
+
+    if (ctx.changed)
+        gooroom_notice_snapshot_schedule (user_data);
+}
+
+static void gooroom_application_notice_update (gpointer user_data);
+
+static gboolean
+gooroom_agent_retry_cb (gpointer user_data)
+{
+    GooroomNoticeCore *core = GOOROOM_NOTICE_CORE (user_data);
+    core->priv->retry_id = 0;
+
+    gooroom_application_notice_update (user_data);
+    return FALSE;
+}
+
+/* jittered exponential backoff, so that a fleet of desktops does not retry in lockstep */
+static void
+gooroom_agent_retry_schedule (gpointer user_data)
+{
+    GooroomNoticeCore *core = GOOROOM_NOTICE_CORE (user_data);
+    GooroomNoticeCorePrivate *priv = core->priv;
+
+    if (priv->retry_id)
+        return;
+
+    guint jitter = priv->retry_delay / 4;
+    guint delay = priv->retry_delay - jitter + g_random_int_range (0, 2 * jitter + 1);
+
+    g_debug ("gooroom_agent_retry_schedule : retry in %u ms\n", delay);
+    priv->retry_id = g_timeout_add (delay, (GSourceFunc) gooroom_agent_retry_cb, user_data);
+    priv->retry_delay = MIN (priv->retry_delay * 2, NOTICE_AGENT_RETRY_MAX);
+}
+
+static void
+gooroom_agent_retry_reset (gpointer user_data)
+{
+    GooroomNoticeCore *core = GOOROOM_NOTICE_CORE (user_data);
+    GooroomNoticeCorePrivate *priv = core->priv;
+
+    if (priv->retry_id)
+    {
+        g_source_remove (priv->retry_id);
+        priv->retry_id = 0;
+    }
+    priv->retry_delay = NOTICE_AGENT_RETRY_MIN;
+}
+
+/* the transport connects to the agent first if it has to */
+static void
+gooroom_application_notice_update (gpointer user_data)
+{
+    g_return_if_fail (user_data != NULL);
+
+    GooroomNoticeCore *core = GOOROOM_NOTICE_CORE (user_data);
+    GooroomNoticeCorePrivate *priv = core->priv;
+
+    const gchar *json = "{\"module\":{\"module_name\":\"noti\",\"task\":{\"task_name\":\"get_noti\",\"in\":{\"login_id\":\"%s\"%s}}}}";
+
+    const gchar *user = g_get_user_name();
+#if 0
+    if (g_strcmp0 (user, "lightdm") == 0)
+        user = "";
+#endif
+    /* with a cursor the agent only sends what changed since, or the full list if it does not know it */
+    g_autofree gchar *cursor = priv->cursor ? g_strdup_printf (",\"cursor\":\"%s\"", priv->cursor) : NULL;
+    gchar *arg = g_strdup_printf (json, user, cursor ? cursor : "");
+
+    /* the round trip includes connecting when the transport has to */
+    priv->agent_call_start = g_get_monotonic_time ();
+    gooroom_notice_stats_count (priv->stats, GOOROOM_NOTICE_COUNTER_AGENT_CALLS, 1);
+
+    gooroom_notice_trace_mark ("agent-request");
+    priv->backend.agent_request (arg, priv->backend_data);
+    g_free (arg);
+}
+
+gboolean
+gooroom_application_notice_update_delay (gpointer user_data)
+{
+    gooroom_application_notice_update (user_data);
+    return FALSE;
+}
+
+void
+gooroom_notice_core_agent_appeared (GooroomNoticeCore *core)
+{
+    gooroom_agent_retry_reset (core);
+    gooroom_application_notice_update (core);
+}
+
+void
+gooroom_notice_core_agent_vanished (GooroomNoticeCore *core)
+{
+    GooroomNoticeCorePrivate *priv = core->priv;
+
+    gooroom_agent_retry_reset (core);
+
+    priv->is_agent = FALSE;
+    priv->restored = FALSE;
+    gooroom_tray_icon_change (core);
+}
+
+void
+gooroom_notice_core_agent_failed (GooroomNoticeCore *core)
+{
+    GooroomNoticeCorePrivate *priv = core->priv;
+
+    priv->agent_call_start = 0;
+    gooroom_notice_stats_count (priv->stats, GOOROOM_NOTICE_COUNTER_AGENT_ERRORS, 1);
+
+    gooroom_agent_retry_schedule (core);
+}
+
+void
+gooroom_notice_core_agent_signal (GooroomNoticeCore *core, const gchar *data)
+{
+    GooroomNoticeCorePrivate *priv = core->priv;
+
+    gooroom_application_notice_get_data_from_json (core, data, TRUE);
+
+    /* normal notices wait for the job so that a flood is paced and digested */
+    gooroom_notice_core_dispatch_critical (core);
+
+    guint total = gooroom_notice_core_pending (priv);
+    if (0 < total || 0 < priv->disabled_cnt)
+    {
+        priv->img_status = TRUE;
+        gooroom_tray_icon_change (core);
+
+        gooroom_notice_core_job_start (core);
+    }
+}
+
+void
+gooroom_notice_core_agent_reply (GooroomNoticeCore *core, const gchar *data)
+{
+    GooroomNoticeCorePrivate *priv = core->priv;
+
+    if (priv->agent_call_start)
+    {
+        gooroom_notice_stats_observe (priv->stats, GOOROOM_NOTICE_HISTOGRAM_AGENT_RTT, g_get_monotonic_time () - priv->agent_call_start);
+        priv->agent_call_start = 0;
+    }
+
+    gooroom_agent_retry_reset (core);
+    gooroom_notice_trace_mark ("agent-reply");
+
+    if (!data)
+        return;
+
+    gooroom_application_notice_get_data_from_json (core, data, FALSE);
+
+    guint total = gooroom_notice_core_pending (priv);
+    if (0 < total || 0 < priv->disabled_cnt)
+    {
+        priv->img_status = TRUE;
+
+        gooroom_notice_core_job_start (core);
+    }
+
+    priv->is_agent = TRUE;
+    gooroom_tray_icon_change (core);
+}
+
+static gboolean
+gooroom_notice_core_update_cb (gpointer user_data)
+{
+    GooroomNoticeCore *core = GOOROOM_NOTICE_CORE (user_data);
+    core->priv->update_id = 0;
+
+    gooroom_notice_trace_mark ("update-delay");
+    return gooroom_application_notice_update_delay (user_data);
+}
+
+static void
+gooroom_notice_core_connectivity_changed (gboolean connected, gpointer user_data)
+{
+    GooroomNoticeCore *core = GOOROOM_NOTICE_CORE (user_data);
+    GooroomNoticeCorePrivate *priv = core->priv;
+    gboolean changed = (priv->is_connected != connected);
+
+    priv->is_connected = connected;
+    gooroom_tray_icon_change (core);
+
+    /* one refetch per transition, however many come in before it runs */
+    if (changed && priv->is_connected && !priv->is_agent && !priv->update_id)
+        priv->update_id = g_timeout_add (500, (GSourceFunc)gooroom_notice_core_update_cb, core);
+}
+
+void
+gooroom_notice_core_set_connected (GooroomNoticeCore *core, gboolean connected)
+{
+    gooroom_notice_connectivity_reset (core->priv->connectivity, connected);
+    gooroom_notice_core_connectivity_changed (connected, core);
+}
+
+void
+gooroom_notice_core_network_changed (GooroomNoticeCore *core, gboolean available)
+{
+    GooroomNoticeCorePrivate *priv = core->priv;
+
+    /* the domain is only known once the agent has answered */
+    gooroom_notice_connectivity_set_probe (priv->connectivity, priv->probe ? priv->default_domain : NULL);
+    gooroom_notice_connectivity_set_available (priv->connectivity, available);
+}
+
+void
+gooroom_notice_core_notification_closed (GooroomNoticeCore *core, gpointer notification)
+{
+    GooroomNoticeCorePrivate *priv = core->priv;
+
+    priv->total--;
+    g_hash_table_remove (priv->data_list, notification);
+}
+
+/* drops title widths and parse buffers sized by the largest payload so far */
+void
+gooroom_notice_core_reclaim (GooroomNoticeCore *core)
+{
+    GooroomNoticeCorePrivate *priv = core->priv;
+
+    gooroom_notice_layout_reclaim (priv->layout);
+
+    gooroom_notice_json_decoder_free (priv->json_decoder);
+    priv->json_decoder = gooroom_notice_json_decoder_new ();
+}
+
+void
+gooroom_notice_core_open (GooroomNoticeCore *core, const gchar *url)
+{
+    GooroomNoticeCorePrivate *priv = core->priv;
+
+    if (url == NULL)
+        url = priv->default_domain;
+
+    priv->img_status = FALSE;
+    gooroom_tray_icon_change (core);
+
+    GooroomNoticeSession session = { priv->client_id, priv->session_id, priv->signing };
+    priv->backend.viewer_open (url, &session, priv->backend_data);
+    gooroom_notice_stats_count (priv->stats, GOOROOM_NOTICE_COUNTER_VIEWER_OPENS, 1);
+
+    gooroom_notice_queue_clear (priv->queue);
+    priv->digest_cnt = 0;
+    gooroom_notice_core_close_all (priv);
+
+    g_hash_table_remove_all (priv->unread);
+    gooroom_notice_snapshot_schedule (core);
+}
+
+void
+gooroom_notice_core_notification_activated (GooroomNoticeCore *core, gpointer notification)
+{
+    GooroomNoticeCorePrivate *priv = core->priv;
+
+    NoticeData *data = g_hash_table_lookup (priv->data_list, notification);
+    if (!data)
+        return;
+
+    /* the url is released along with the notification */
+    g_autofree gchar *url = g_strdup (data->url);
+    gooroom_notice_core_open (core, url);
+}
+
+static void
+gooroom_notice_core_show (gpointer user_data, NoticeData *n, const gchar *title, GooroomNoticeUrgency urgency)
+{
+    GooroomNoticeCore *core = GOOROOM_NOTICE_CORE (user_data);
+    GooroomNoticeCorePrivate *priv = core->priv;
+
+    priv->total++;
+
+    gpointer notification = priv->backend.notification_show (title, n->icon, urgency, priv->backend_data);
+    g_hash_table_insert (priv->data_list, notification, n);
+
+    /* warm the page up while the notification is read */
+    if (n->url && priv->backend.viewer_prefetch)
+    {
+        GooroomNoticeSession session = { priv->client_id, priv->session_id, priv->signing };
+        priv->backend.viewer_prefetch (n->url, &session, priv->backend_data);
+    }
+
+    gooroom_notice_stats_count (priv->stats, GOOROOM_NOTICE_COUNTER_NOTICES_SHOWN, 1);
+
+    /* restored and synthetic notices have no arrival time */
+    if (n->received)
+        gooroom_notice_stats_observe (priv->stats, GOOROOM_NOTICE_HISTOGRAM_DISPLAY_LATENCY, g_get_monotonic_time () - n->received);
+}
+
+static void
+gooroom_notice_core_show_notice (gpointer user_data, NoticeData *n, GooroomNoticeUrgency urgency)
+{
+    GooroomNoticeCore *core = GOOROOM_NOTICE_CORE (user_data);
+    g_autofree gchar *title = gooroom_notice_layout_title (core->priv->layout, n->title, 0);
+
+    gooroom_notice_core_show (user_data, n, title, urgency);
+}
+
+/*
+ * Shows up to dispatch_burst notices in queue order. Only normal
+ * notices count against the on-screen limit; when it is reached,
+ * critical notices queued behind them still go out.
+ */
+static gint
+gooroom_notice_core_dispatch (gpointer user_data)
+{
+    GooroomNoticeCore *core = GOOROOM_NOTICE_CORE (user_data);
+    GooroomNoticeCorePrivate *priv = core->priv;
+
+    GooroomNoticeUrgency urgency;
+    NoticeData *n;
+    gint shown = 0;
+
+    while (shown < priv->dispatch_burst && gooroom_notice_queue_peek (priv->queue, &urgency))
+    {
+        if (urgency != GOOROOM_NOTICE_URGENCY_CRITICAL && priv->notification_limit <= priv->total)
+        {
+            urgency = GOOROOM_NOTICE_URGENCY_CRITICAL;
+            n = gooroom_notice_queue_pop_class (priv->queue, urgency);
+        }
+        else
+        {
+            n = gooroom_notice_queue_pop (priv->queue, &urgency);
+        }
+
+        if (!n)
+            break;
+
+        gooroom_notice_core_show_notice (user_data, n, urgency);
+        shown++;
+    }
+
+    return shown;
+}
+
+/* shows up to dispatch_burst critical notices, whatever is on screen */
+static gint
+gooroom_notice_core_dispatch_critical (gpointer user_data)
+{
+    GooroomNoticeCore *core = GOOROOM_NOTICE_CORE (user_data);
+    GooroomNoticeCorePrivate *priv = core->priv;
+
+    NoticeData *n;
+    gint shown = 0;
+
+    while (shown < priv->dispatch_burst &&
+           (n = gooroom_notice_queue_pop_class (priv->queue, GOOROOM_NOTICE_URGENCY_CRITICAL)))
+    {
+        gooroom_notice_core_show_notice (user_data, n, GOOROOM_NOTICE_URGENCY_CRITICAL);
+        shown++;
+    }
+
+    return shown;
+}
+
+/* a notice made up by the applet itself, pointing at the notice portal */
+static NoticeData*
+gooroom_notice_core_synthetic (GooroomNoticeCorePrivate *priv, const gchar *title)
+{
+    return gooroom_notice_data_new (NULL, NULL, title, priv->default_domain, NOTIFICATION_MSG_ICON);
+}
+
+/*
+ * Collapses the normal backlog into one digest. The digest counts
+ * against the on-screen limit like any normal notice; while the limit
+ * is reached, the collapsed notices add up in digest_cnt and a single
+ * digest covering all of them goes out once there is room.
+ */
+static void
+gooroom_notice_core_digest (gpointer user_data)
+{
+    GooroomNoticeCore *core = GOOROOM_NOTICE_CORE (user_data);
+    GooroomNoticeCorePrivate *priv = core->priv;
+
+    guint cnt = gooroom_notice_queue_class_length (priv->queue, GOOROOM_NOTICE_URGENCY_NORMAL);
+
+    gooroom_notice_queue_clear_class (priv->queue, GOOROOM_NOTICE_URGENCY_NORMAL);
+    gooroom_notice_stats_count (priv->stats, GOOROOM_NOTICE_COUNTER_NOTICES_COLLAPSED, cnt);
+    priv->digest_cnt += cnt;
+
+    if (priv->notification_limit <= priv->total)
+    {
+        g_debug ("gooroom_notice_core_digest : %u notices held back\n", priv->digest_cnt);
+        return;
+    }
+
+    cnt = priv->digest_cnt;
+    priv->digest_cnt = 0;
+
+    g_autofree gchar *title = gooroom_notice_layout_title (priv->layout, _("Notice"), (1 < cnt) ? cnt : 0);
+    NoticeData *n = gooroom_notice_core_synthetic (priv, title);
+
+    g_debug ("gooroom_notice_core_digest : collapsed %u notices\n", cnt);
+    gooroom_notice_stats_count (priv->stats, GOOROOM_NOTICE_COUNTER_DIGESTS, 1);
+    gooroom_notice_core_show (user_data, n, title, GOOROOM_NOTICE_URGENCY_NORMAL);
+}
+
+static void
+gooroom_notice_core_job_start (gpointer user_data)
+{
+    GooroomNoticeCore *core = GOOROOM_NOTICE_CORE (user_data);
+    GooroomNoticeCorePrivate *priv = core->priv;
+
+    if (priv->is_job)
+        return;
+
+    priv->is_job = TRUE;
+    g_timeout_add (priv->dispatch_interval, (GSourceFunc) gooroom_notice_core_job, user_data);
+}
+
+gboolean
+gooroom_notice_core_job (gpointer user_data)
+{
+    g_return_val_if_fail (user_data != NULL, FALSE);
+
+    GooroomNoticeCore *core = GOOROOM_NOTICE_CORE (user_data);
+    GooroomNoticeCorePrivate *priv = core->priv;
+
+    priv->is_job = TRUE;
+
+    if (0 < priv->digest_cnt ||
+        priv->digest_threshold < gooroom_notice_queue_class_length (priv->queue, GOOROOM_NOTICE_URGENCY_NORMAL))
+        gooroom_notice_core_digest (user_data);
+
+    gint shown = gooroom_notice_core_dispatch (user_data);
+
+    guint total = gooroom_notice_core_pending (priv);
+
+    if (0 != total || 0 != shown)
+        return priv->is_job;
+
+    if (0 != priv->disabled_cnt)
+    {
+        /* like a digest, the summary waits for room on screen instead of being dropped */
+        if (priv->notification_limit <= priv->total)
+            return priv->is_job;
+
+        g_autofree gchar *no_title = gooroom_notice_layout_title (priv->layout, _("Notice"), (1 < priv->disabled_cnt) ? priv->disabled_cnt : 0);
+
+        NoticeData *n = gooroom_notice_core_synthetic (priv, no_title);
+        gooroom_notice_core_show (user_data, n, no_title, GOOROOM_NOTICE_URGENCY_NORMAL);
+    }
+
+    priv->is_job = FALSE;
+    return priv->is_job;
+}
+
+static void
+gooroom_notice_core_gauges (GVariantBuilder *builder, gpointer user_data)
+{
+    GooroomNoticeCore *core = GOOROOM_NOTICE_CORE (user_data);
+    GooroomNoticeCorePrivate *priv = core->priv;
+
+    g_variant_builder_add (builder, "{sv}", "queue_length", g_variant_new_uint32 (gooroom_notice_queue_class_length (priv->queue, GOOROOM_NOTICE_URGENCY_NORMAL)));
+    g_variant_builder_add (builder, "{sv}", "urgent_queue_length", g_variant_new_uint32 (gooroom_notice_queue_class_length (priv->queue, GOOROOM_NOTICE_URGENCY_CRITICAL)));
+    g_variant_builder_add (builder, "{sv}", "on_screen", g_variant_new_uint32 (MAX (priv->total, 0)));
+    g_variant_builder_add (builder, "{sv}", "unread", g_variant_new_uint32 (g_hash_table_size (priv->unread)));
+    g_variant_builder_add (builder, "{sv}", "seen_index", g_variant_new_uint32 (gooroom_notice_index_size (priv->index)));
+}
+
+GooroomNoticeStats*
+gooroom_notice_core_get_stats (GooroomNoticeCore *core)
+{
+    return core->priv->stats;
+}
+
+static void
+gooroom_notice_core_finalize (GObject *object)
+{
+    GooroomNoticeCore *core = GOOROOM_NOTICE_CORE (object);
+    GooroomNoticeCorePrivate *priv = core->priv;
+
+    /* skips a write still queued, then saves the last batch window in its place */
+    if (priv->cancellable)
+        g_cancellable_cancel (priv->cancellable);
+
+    if (priv->snapshot_id || priv->snapshot_writing || priv->snapshot_dirty)
+    {
+        GError *error = NULL;
+
+        if (!gooroom_notice_snapshot_write (priv->snapshot_path, gooroom_notice_snapshot_build (priv), &error))
+        {
+            g_debug ("gooroom_notice_core_finalize : %s\n", error->message);
+            g_error_free (error);
+        }
+    }
+
+    if (priv->signing)
+        g_free (priv->signing);
+
+    if (priv->session_id)
+        g_free (priv->session_id);
+
+    if (priv->client_id)
+        g_free (priv->client_id);
+
+    if (priv->default_domain)
+        g_free (priv->default_domain);
+
+    g_free (priv->cursor);
+
+    if (priv->config)
+    {
+        g_key_file_free (priv->config);
+        priv->config = NULL;
+    }
+
+    if (priv->queue)
+    {
+        gooroom_notice_queue_free (priv->queue);
+        priv->queue = NULL;
+    }
+
+    if (priv->data_list)
+    {
+        gooroom_notice_core_close_all (priv);
+        g_hash_table_destroy (priv->data_list);
+        priv->data_list = NULL;
+    }
+
+    if (priv->json_decoder)
+    {
+        gooroom_notice_json_decoder_free (priv->json_decoder);
+        priv->json_decoder = NULL;
+    }
+
+    if (priv->snapshot_id)
+    {
+        g_source_remove (priv->snapshot_id);
+        priv->snapshot_id = 0;
+    }
+
+    g_free (priv->snapshot_path);
+    priv->snapshot_path = NULL;
+
+    if (priv->unread)
+    {
+        g_hash_table_destroy (priv->unread);
+        priv->unread = NULL;
+    }
+
+    if (priv->index)
+    {
+        gooroom_notice_index_free (priv->index);
+        priv->index = NULL;
+    }
+
+    if (priv->cancellable)
+    {
+        g_cancellable_cancel (priv->cancellable);
+        g_object_unref (priv->cancellable);
+        priv->cancellable = NULL;
+    }
+
+    if (priv->retry_id)
+    {
+        g_source_remove (priv->retry_id);
+        priv->retry_id = 0;
+    }
+
+    if (priv->update_id)
+    {
+        g_source_remove (priv->update_id);
+        priv->update_id = 0;
+    }
+
+    gooroom_notice_connectivity_free (priv->connectivity);
+    priv->connectivity = NULL;
+
+    gooroom_notice_stats_free (priv->stats);
+    gooroom_notice_layout_free (priv->layout);
+    priv->stats = NULL;
+
+    G_OBJECT_CLASS (gooroom_notice_core_parent_class)->finalize (object);
+}
+
+static void
+gooroom_notice_core_init (GooroomNoticeCore *core)
+{
+    GooroomNoticeCorePrivate *priv;
+    priv = core->priv = gooroom_notice_core_get_instance_private (core);
+    priv->backend_data = NULL;
+    priv->img_status = FALSE;
+    priv->is_job     = FALSE;
+    priv->is_agent   = FALSE;
+    priv->is_connected = FALSE;
+
+    priv->cancellable = g_cancellable_new ();
+    priv->stats      = gooroom_notice_stats_new (gooroom_notice_core_gauges, core);
+    priv->agent_call_start = 0;
+    priv->retry_id   = 0;
+    priv->retry_delay = NOTICE_AGENT_RETRY_MIN;
+
+    gooroom_notice_config_load (core);
+
+    priv->total      = 0;
+    priv->digest_cnt = 0;
+    priv->queue      = gooroom_notice_queue_new ((gint64)MAX (gooroom_notice_core_config_get_int (core, "UrgencyAging", NOTICE_URGENCY_AGING), 0) * 1000);
+    priv->json_decoder = gooroom_notice_json_decoder_new ();
+    priv->dispatch_interval  = MAX (gooroom_notice_core_config_get_int (core, "DispatchInterval", NOTICE_DISPATCH_INTERVAL), 10);
+    priv->dispatch_burst     = MAX (gooroom_notice_core_config_get_int (core, "DispatchBurst", NOTICE_DISPATCH_BURST), 1);
+    priv->digest_threshold   = MAX (gooroom_notice_core_config_get_int (core, "DigestThreshold", NOTICE_DIGEST_THRESHOLD), 1);
+    priv->notification_limit = MAX (gooroom_notice_core_config_get_int (core, "NotificationLimit", NOTIFICATION_LIMIT), 1);
+
+    priv->update_id = 0;
+    /* notices come from the local agent, so an unreachable notice host must not hide them unless asked to */
+    priv->probe = (gooroom_notice_core_config_get_int (core, "ConnectivityProbe", 0) != 0);
+    priv->connectivity = gooroom_notice_connectivity_new (
+            MAX (gooroom_notice_core_config_get_int (core, "ConnectivityUpDelay", NOTICE_CONNECTIVITY_UP_DELAY), 0),
+            MAX (gooroom_notice_core_config_get_int (core, "ConnectivityDownDelay", NOTICE_CONNECTIVITY_DOWN_DELAY), 0),
+            gooroom_notice_core_connectivity_changed, core);
+
+    priv->index      = gooroom_notice_index_new (gooroom_notice_core_config_get_int (core, "DuplicateIndexSize", NOTICE_INDEX_SIZE));
+    priv->unread     = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, gooroom_notice_data_unref);
+    priv->data_list  = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, gooroom_notice_data_unref);
+
+    priv->signing    = NULL;
+    priv->session_id = NULL;
+    priv->client_id  = NULL;
+    priv->default_domain = NULL;
+    priv->cursor = NULL;
+    priv->disabled_cnt = 0;
+
+    priv->snapshot_path = g_build_filename (g_get_user_cache_dir (), PACKAGE_NAME, NOTICE_SNAPSHOT_FILE, NULL);
+    priv->snapshot_id = 0;
+    priv->snapshot_writing = FALSE;
+    priv->snapshot_dirty = FALSE;
+    priv->restored = FALSE;
+
+    gooroom_notice_snapshot_restore (core);
+}
+
+static void
+gooroom_notice_core_class_init (GooroomNoticeCoreClass *class)
+{
+    GObjectClass *object_class;
+    object_class = G_OBJECT_CLASS (class);
+    object_class->finalize = gooroom_notice_core_finalize;
+}
+
+GooroomNoticeCore*
+gooroom_notice_core_new (const GooroomNoticeBackend *backend, gpointer user_data)
+{
+    g_return_val_if_fail (backend != NULL, NULL);
+
+    GooroomNoticeCore *core = g_object_new (TYPE_GOOROOM_NOTICE_CORE, NULL);
+
+    core->priv->backend = *backend;
+    core->priv->backend_data = user_data;
+
+    /* without a measure the width is a cluster count, as it always was */
+    if (backend->text_width)
+        core->priv->layout = gooroom_notice_layout_new (backend->text_width, user_data,
+                MAX (gooroom_notice_core_config_get_int (core, "TitleWidth", NOTIFICATION_TITLE_WIDTH), 1));
+    else
+        core->priv->layout = gooroom_notice_layout_new (NULL, NULL, NOTIFICATION_TEXT_LIMIT);
+
+    return core;
+}
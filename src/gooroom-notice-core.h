@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2018-2019 Gooroom <gooroom@gooroom.kr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#ifndef __GOOROOM_NOTICE_CORE_H__
+#define __GOOROOM_NOTICE_CORE_H__
+
+#include <glib.h>
+#include <glib-object.h>
+
+#include "gooroom-notice-stats.h"
+
+G_BEGIN_DECLS
+
+#define TYPE_GOOROOM_NOTICE_CORE           (gooroom_notice_core_get_type ())
+#define GOOROOM_NOTICE_CORE(obj)           (G_TYPE_CHECK_INSTANCE_CAST ((obj), TYPE_GOOROOM_NOTICE_CORE, GooroomNoticeCore))
+#define GOOROOM_NOTICE_CORE_CLASS(obj)     (G_TYPE_CHECK_CLASS_CAST ((obj), TYPE_GOOROOM_NOTICE_CORE, GooroomNoticeCoreClass))
+#define IS_GOOROOM_NOTICE_CORE(obj)        (G_TYPE_CHECK_INSTANCE_TYPE ((obj), TYPE_GOOROOM_NOTICE_CORE))
+#define IS_GOOROOM_NOTICE_CORE_CLASS(obj)  (G_TYPE_CHECK_CLASS_TYPE ((obj), TYPE_GOOROOM_NOTICE_CORE))
+#define GOOROOM_NOTICE_CORE_GET_CLASS(obj) (G_TYPE_INSTANCE_GET_CLASS ((obj), TYPE_GOOROOM_NOTICE_CORE, GooroomNoticeCoreClass))
+
+typedef struct _GooroomNoticeCore        GooroomNoticeCore;
+typedef struct _GooroomNoticeCoreClass   GooroomNoticeCoreClass;
+typedef struct _GooroomNoticeCorePrivate GooroomNoticeCorePrivate;
+
+struct _GooroomNoticeCore {
+    GObject parent;
+    GooroomNoticeCorePrivate *priv;
+};
+
+struct _GooroomNoticeCoreClass {
+    GObjectClass parent_class;
+};
+
+typedef enum
+{
+    GOOROOM_NOTICE_INDICATOR_PASSIVE,
+    GOOROOM_NOTICE_INDICATOR_ACTIVE,
+    GOOROOM_NOTICE_INDICATOR_ATTENTION
+} GooroomNoticeIndicatorStatus;
+
+/* urgent notices arrive as set_noti signals */
+typedef enum
+{
+    GOOROOM_NOTICE_URGENCY_NORMAL,
+    GOOROOM_NOTICE_URGENCY_CRITICAL,
+    GOOROOM_NOTICE_URGENCY_LAST
+} GooroomNoticeUrgency;
+
+/* credentials the notice portal expects as cookies */
+typedef struct
+{
+    const gchar *client_id;
+    const gchar *session_id;
+    const gchar *signing;
+} GooroomNoticeSession;
+
+/*
+ * Everything the core needs from the desktop. The applet binary plugs
+ * in libnotify, the indicator, the WebKit viewer and the system bus;
+ * benchmarks plug in in-memory versions. @user_data is the pointer given
+ * to gooroom_notice_core_new().
+ *
+ * notification_show returns an opaque handle that is later passed back
+ * through gooroom_notice_core_notification_activated() and
+ * gooroom_notice_core_notification_closed(). agent_request sends a
+ * do_task request; the outcome is reported through the
+ * gooroom_notice_core_agent_*() calls. text_width returns the pixel
+ * width of a title fragment in the notification font; it may be NULL,
+ * titles are then limited by character count. viewer_prefetch is told
+ * about the page of every notice put on screen so that it can load it
+ * ahead of a click; it may be NULL.
+ */
+typedef struct
+{
+    gpointer (*notification_show)    (const gchar *title, const gchar *icon, GooroomNoticeUrgency urgency, gpointer user_data);
+    void     (*notification_close)   (gpointer notification, gpointer user_data);
+    void     (*indicator_set_status) (GooroomNoticeIndicatorStatus status, gpointer user_data);
+    void     (*viewer_open)          (const gchar *url, const GooroomNoticeSession *session, gpointer user_data);
+    void     (*agent_request)        (const gchar *request, gpointer user_data);
+    gint     (*text_width)           (const gchar *text, gsize len, gpointer user_data);
+    void     (*viewer_prefetch)      (const gchar *url, const GooroomNoticeSession *session, gpointer user_data);
+} GooroomNoticeBackend;
+
+GType gooroom_notice_core_get_type (void);
+GooroomNoticeCore *gooroom_notice_core_new (const GooroomNoticeBackend *backend, gpointer user_data);
+
+GooroomNoticeStats *gooroom_notice_core_get_stats (GooroomNoticeCore *core);
+gint gooroom_notice_core_config_get_int (GooroomNoticeCore *core, const gchar *key, gint default_value);
+
+gboolean gooroom_notice_core_job (gpointer data);
+gboolean gooroom_application_notice_update_delay (gpointer user_data);
+void gooroom_application_notice_get_data_from_json (gpointer user_data, const gchar *data, gboolean urgency);
+
+void gooroom_notice_core_open (GooroomNoticeCore *core, const gchar *url);
+void gooroom_notice_core_reclaim (GooroomNoticeCore *core);
+/* set_connected takes effect at once; network_changed is debounced and probed first */
+void gooroom_notice_core_set_connected (GooroomNoticeCore *core, gboolean connected);
+void gooroom_notice_core_network_changed (GooroomNoticeCore *core, gboolean available);
+
+void gooroom_notice_core_notification_activated (GooroomNoticeCore *core, gpointer notification);
+void gooroom_notice_core_notification_closed (GooroomNoticeCore *core, gpointer notification);
+
+void gooroom_notice_core_agent_appeared (GooroomNoticeCore *core);
+void gooroom_notice_core_agent_vanished (GooroomNoticeCore *core);
+void gooroom_notice_core_agent_failed (GooroomNoticeCore *core);
+void gooroom_notice_core_agent_signal (GooroomNoticeCore *core, const gchar *data);
+void gooroom_notice_core_agent_reply (GooroomNoticeCore *core, const gchar *data);
+
+G_END_DECLS
+
+#endif /* __GOOROOM_NOTICE_CORE_H__*/
@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2018 - 2019 Gooroom <gooroom@gooroom.kr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <string.h>
+
+#include <glib.h>
+
+#include "gooroom-notice-data.h"
+
+#define NOTICE_BATCH_CHUNK_SIZE  (4096)
+
+struct _NoticeBatch
+{
+    GStringChunk *strings;
+    gint          ref_count;
+};
+
+NoticeBatch *
+gooroom_notice_batch_new (void)
+{
+    NoticeBatch *batch;
+    batch = g_slice_new0 (NoticeBatch);
+
+    batch->strings = g_string_chunk_new (NOTICE_BATCH_CHUNK_SIZE);
+    batch->ref_count = 1;
+
+    return batch;
+}
+
+NoticeBatch *
+gooroom_notice_batch_ref (NoticeBatch *batch)
+{
+    g_return_val_if_fail (batch != NULL, NULL);
+
+    batch->ref_count++;
+    return batch;
+}
+
+void
+gooroom_notice_batch_unref (NoticeBatch *batch)
+{
+    if (!batch || --batch->ref_count != 0)
+        return;
+
+    g_string_chunk_free (batch->strings);
+    g_slice_free (NoticeBatch, batch);
+}
+
+NoticeData *
+gooroom_notice_data_new (NoticeBatch *batch,
+                         const gchar *key,
+                         const gchar *title,
+                         const gchar *url,
+                         const gchar *icon)
+{
+    NoticeData *n;
+    n = g_slice_new0 (NoticeData);
+
+    if (!title)
+        title = "";
+
+    if (batch)
+    {
+        n->key = key ? g_string_chunk_insert (batch->strings, key) : NULL;
+        n->title = g_string_chunk_insert (batch->strings, title);
+        n->url = url ? g_string_chunk_insert (batch->strings, url) : NULL;
+        n->batch = gooroom_notice_batch_ref (batch);
+    }
+    else
+    {
+        gsize key_len = key ? strlen (key) + 1 : 0;
+        gsize title_len = strlen (title) + 1;
+        gsize url_len = url ? strlen (url) + 1 : 0;
+
+        /* one allocation, laid out as title, key, url */
+        n->strings = g_malloc (title_len + key_len + url_len);
+
+        n->title = memcpy (n->strings, title, title_len);
+        n->key = key ? memcpy (n->strings + title_len, key, key_len) : NULL;
+        n->url = url ? memcpy (n->strings + title_len + key_len, url, url_len) : NULL;
+    }
+
+    n->icon = g_intern_string (icon);
+    n->ref_count = 1;
+
+    return n;
+}
+
+NoticeData *
+gooroom_notice_data_copy (NoticeData *n)
+{
+    g_return_val_if_fail (n != NULL, NULL);
+
+    NoticeData *copy = gooroom_notice_data_new (NULL, n->key, n->title, n->url, n->icon);
+    copy->received = n->received;
+
+    return copy;
+}
+
+NoticeData *
+gooroom_notice_data_ref (NoticeData *n)
+{
+    g_return_val_if_fail (n != NULL, NULL);
+
+    n->ref_count++;
+    return n;
+}
+
+void
+gooroom_notice_data_unref (gpointer data)
+{
+    NoticeData *n = (NoticeData *)data;
+
+    if (!n || --n->ref_count != 0)
+        return;
+
+    gooroom_notice_batch_unref (n->batch);
+    g_free (n->strings);
+    g_slice_free (NoticeData, n);
+}
@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2018-2019 Gooroom <gooroom@gooroom.kr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#ifndef __GOOROOM_NOTICE_DATA_H__
+#define __GOOROOM_NOTICE_DATA_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/*
+ * The strings of all notices decoded from one payload live in one
+ * string chunk owned by a NoticeBatch. Every notice holds a reference on
+ * its batch, so the chunk is released when the last notice of the
+ * payload goes away. That suits notices on their way to the screen;
+ * notices kept for the rest of the session are created without a batch
+ * or copied out of it, and then own a single block for their strings.
+ * Icon names are interned and never freed.
+ */
+typedef struct _NoticeBatch NoticeBatch;
+
+typedef struct
+{
+    gchar        *key;
+    gchar        *url;
+    gchar        *title;
+    const gchar  *icon;
+    gint64        received;
+
+    NoticeBatch  *batch;
+    gchar        *strings;
+    gint          ref_count;
+}NoticeData;
+
+NoticeBatch *gooroom_notice_batch_new (void);
+NoticeBatch *gooroom_notice_batch_ref (NoticeBatch *batch);
+void gooroom_notice_batch_unref (NoticeBatch *batch);
+
+/* @batch may be NULL for a notice that owns its strings */
+NoticeData *gooroom_notice_data_new (NoticeBatch *batch,
+                                     const gchar *key,
+                                     const gchar *title,
+                                     const gchar *url,
+                                     const gchar *icon);
+/* a notice with the same fields that does not keep @n's batch alive */
+NoticeData *gooroom_notice_data_copy (NoticeData *n);
+NoticeData *gooroom_notice_data_ref (NoticeData *n);
+void gooroom_notice_data_unref (gpointer n);
+
+G_END_DECLS
+
+#endif /* __GOOROOM_NOTICE_DATA_H__*/
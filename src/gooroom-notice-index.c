@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2018 - 2019 Gooroom <gooroom@gooroom.kr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <glib.h>
+
+#include "gooroom-notice-index.h"
+
+struct _GooroomNoticeIndex
+{
+    GHashTable *table;   /* key -> link in order */
+    GQueue      order;   /* least recently seen first, owns the keys */
+    guint       max_size;
+};
+
+GooroomNoticeIndex *
+gooroom_notice_index_new (guint max_size)
+{
+    GooroomNoticeIndex *notice_index;
+    notice_index = g_new0 (GooroomNoticeIndex, 1);
+
+    notice_index->table = g_hash_table_new (g_str_hash, g_str_equal);
+    g_queue_init (&notice_index->order);
+    notice_index->max_size = MAX (max_size, 1);
+
+    return notice_index;
+}
+
+void
+gooroom_notice_index_free (GooroomNoticeIndex *notice_index)
+{
+    if (!notice_index)
+        return;
+
+    g_hash_table_destroy (notice_index->table);
+    g_queue_foreach (&notice_index->order, (GFunc) g_free, NULL);
+    g_queue_clear (&notice_index->order);
+    g_free (notice_index);
+}
+
+gboolean
+gooroom_notice_index_add (GooroomNoticeIndex *notice_index, const gchar *key)
+{
+    g_return_val_if_fail (notice_index != NULL, TRUE);
+
+    if (!key)
+        return TRUE;
+
+    GList *link = g_hash_table_lookup (notice_index->table, key);
+    if (link)
+    {
+        g_queue_unlink (&notice_index->order, link);
+        g_queue_push_tail_link (&notice_index->order, link);
+        return FALSE;
+    }
+
+    if (notice_index->max_size <= g_queue_get_length (&notice_index->order))
+    {
+        gchar *oldest = g_queue_pop_head (&notice_index->order);
+        g_hash_table_remove (notice_index->table, oldest);
+        g_free (oldest);
+    }
+
+    g_queue_push_tail (&notice_index->order, g_strdup (key));
+    g_hash_table_insert (notice_index->table, notice_index->order.tail->data, notice_index->order.tail);
+
+    return TRUE;
+}
+
+guint
+gooroom_notice_index_size (GooroomNoticeIndex *notice_index)
+{
+    g_return_val_if_fail (notice_index != NULL, 0);
+
+    return g_queue_get_length (&notice_index->order);
+}
+
+void
+gooroom_notice_index_foreach (GooroomNoticeIndex *notice_index, GFunc func, gpointer user_data)
+{
+    g_return_if_fail (notice_index != NULL);
+
+    g_queue_foreach (&notice_index->order, func, user_data);
+}
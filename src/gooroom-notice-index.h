@@ -0,0 +1,45 @@
+/*
+ * Copyright (C) 2018-2019 Gooroom <gooroom@gooroom.kr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#ifndef __GOOROOM_NOTICE_INDEX_H__
+#define __GOOROOM_NOTICE_INDEX_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GooroomNoticeIndex GooroomNoticeIndex;
+
+GooroomNoticeIndex *gooroom_notice_index_new (guint max_size);
+void gooroom_notice_index_free (GooroomNoticeIndex *notice_index);
+
+/*
+ * Records @key and returns TRUE if it was not seen yet. A known key only
+ * has its recency refreshed and FALSE is returned. Once @max_size keys
+ * are held the least recently seen one is evicted.
+ */
+gboolean gooroom_notice_index_add (GooroomNoticeIndex *notice_index, const gchar *key);
+guint gooroom_notice_index_size (GooroomNoticeIndex *notice_index);
+
+/* visits the keys from the least to the most recently seen */
+void gooroom_notice_index_foreach (GooroomNoticeIndex *notice_index, GFunc func, gpointer user_data);
+
+G_END_DECLS
+
+#endif /* __GOOROOM_NOTICE_INDEX_H__*/
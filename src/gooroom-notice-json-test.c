@@ -0,0 +1,313 @@
+/*
+ * Copyright (c) 2018 - 2019 Gooroom <gooroom@gooroom.kr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <string.h>
+
+#include <glib.h>
+
+#include "gooroom-notice-json.h"
+
+typedef struct
+{
+    const gchar *name;
+    const gchar *data;
+    gboolean     reply;
+    gboolean     parsed;
+    const gchar *events;
+}JsonCase;
+
+static const JsonCase json_cases[] =
+{
+    { "signal/notices",
+      "{\"signing\":\"s\",\"client_id\":\"c\",\"session_id\":\"x\",\"default_noti_domain\":\"https://d\","
+      "\"enabled_title_view_notis\":[{\"noti_id\":\"1\",\"title\":\"a\",\"url\":\"https://d/1\"},{\"id\":2,\"title\":\"b\"}],"
+      "\"disabled_title_view_cnt\":3}",
+      FALSE, TRUE,
+      "field(0,s) field(1,c) field(2,x) field(3,https://d) notice(1,a,https://d/1) notice(2,b,-) disabled(3) " },
+    { "signal/escapes",
+      "{\"enabled_title_view_notis\":[{\"id\":\"1\",\"title\":\"\\\"q\\\" \\u00e9\\ud83d\\ude00\\n\"}]}",
+      FALSE, TRUE,
+      "notice(1,\"q\" \xc3\xa9\xf0\x9f\x98\x80\n,-) " },
+    { "signal/null and nested values",
+      "{\"enabled_title_view_notis\":[{\"id\":\"1\",\"title\":null,\"url\":{\"x\":[1,2]},\"extra\":[true,false,-1.5e+3]}],"
+      "\"unknown\":{\"a\":[{}]}}",
+      FALSE, TRUE,
+      "notice(1,,-) " },
+    { "signal/delta",
+      "{\"sync\":\"delta\",\"cursor\":\"c1\",\"retracted_notis\":[\"4\",5,null]}",
+      FALSE, TRUE,
+      "field(5,delta) field(4,c1) retracted(4) retracted(5) " },
+    { "signal/whitespace around",
+      " \r\n\t{ \"disabled_title_view_cnt\" : 1 } \n",
+      FALSE, TRUE,
+      "disabled(1) " },
+    { "signal/trailing data",
+      "{\"disabled_title_view_cnt\":1} x",
+      FALSE, FALSE, "" },
+    { "signal/second value",
+      "{\"disabled_title_view_cnt\":1}{}",
+      FALSE, FALSE, "" },
+    { "signal/embedded nul",
+      "{\"enabled_title_view_notis\":[{\"id\":\"1\",\"title\":\"a\\u0000b\"}]}",
+      FALSE, FALSE, "" },
+    { "signal/truncated",
+      "{\"enabled_title_view_notis\":[{\"id\":\"1\",\"title\":\"a\"}",
+      FALSE, FALSE, "" },
+    { "signal/broken after notices",
+      "{\"enabled_title_view_notis\":[{\"id\":\"1\"}],\"x\":tru}",
+      FALSE, FALSE, "" },
+    { "signal/nul in a field",
+      "{\"session_id\":\"\\u0000\"}",
+      FALSE, FALSE, "" },
+    { "signal/nul in a retraction",
+      "{\"retracted_notis\":[\"4\",\"5\\u0000\"]}",
+      FALSE, FALSE, "" },
+    { "signal/invalid utf-8",
+      "{\"enabled_title_view_notis\":[{\"id\":\"1\",\"title\":\"a\xff\"}]}",
+      FALSE, FALSE, "" },
+    { "signal/overlong utf-8",
+      "{\"enabled_title_view_notis\":[{\"id\":\"1\",\"url\":\"\xc0\xaf\"}]}",
+      FALSE, FALSE, "" },
+    { "signal/count at the edges",
+      "{\"disabled_title_view_cnt\":2147483647}",
+      FALSE, TRUE,
+      "disabled(2147483647) " },
+    { "signal/count beyond int",
+      "{\"disabled_title_view_cnt\":4294967296}",
+      FALSE, TRUE,
+      "disabled(2147483647) " },
+    { "signal/count below int",
+      "{\"disabled_title_view_cnt\":-4294967296}",
+      FALSE, TRUE,
+      "disabled(-2147483648) " },
+    { "signal/trailing comma",
+      "{\"retracted_notis\":[\"4\",]}",
+      FALSE, FALSE, "" },
+    { "signal/missing comma",
+      "{\"sync\":\"full\" \"cursor\":\"c\"}",
+      FALSE, FALSE, "" },
+    { "signal/empty",
+      "",
+      FALSE, FALSE, "" },
+    { "reply/ok",
+      "{\"module\":{\"module_name\":\"noti\",\"task\":{\"task_name\":\"get_noti\",\"out\":"
+      "{\"noti_info\":{\"enabled_title_view_notis\":[{\"id\":\"1\",\"title\":\"a\"}]},\"status\":\"200\"}}}}",
+      TRUE, TRUE,
+      "notice(1,a,-) " },
+    { "reply/status not ok",
+      "{\"module\":{\"task\":{\"out\":{\"status\":\"500\",\"noti_info\":{\"disabled_title_view_cnt\":1}}}}}",
+      TRUE, FALSE, "" },
+    { "reply/no noti_info",
+      "{\"module\":{\"task\":{\"out\":{\"status\":\"200\",\"noti_info\":null}}}}",
+      TRUE, FALSE, "" },
+    { "reply/broken after out",
+      "{\"module\":{\"task\":{\"out\":{\"status\":\"200\",\"noti_info\":{}}},\"x\":[1,]}}",
+      TRUE, FALSE, "" },
+    { "reply/trailing data",
+      "{\"module\":{\"task\":{\"out\":{\"status\":\"200\",\"noti_info\":{}}}}}]",
+      TRUE, FALSE, "" },
+};
+
+static void
+on_notice (const gchar *id, const gchar *title, const gchar *url, gpointer user_data)
+{
+    g_string_append_printf ((GString *)user_data, "notice(%s,%s,%s) ", id ? id : "-", title, url ? url : "-");
+}
+
+static void
+on_field (NoticeJsonField field, const gchar *value, gpointer user_data)
+{
+    g_string_append_printf ((GString *)user_data, "field(%d,%s) ", field, value);
+}
+
+static void
+on_disabled_cnt (gint cnt, gpointer user_data)
+{
+    g_string_append_printf ((GString *)user_data, "disabled(%d) ", cnt);
+}
+
+static void
+on_retracted (const gchar *id, gpointer user_data)
+{
+    g_string_append_printf ((GString *)user_data, "retracted(%s) ", id);
+}
+
+static const NoticeJsonHandler test_handler =
+{
+    on_notice,
+    on_field,
+    on_disabled_cnt,
+    on_retracted
+};
+
+static void
+test_json_case (gconstpointer data)
+{
+    const JsonCase *c = (const JsonCase *)data;
+    GooroomNoticeJsonDecoder *decoder = gooroom_notice_json_decoder_new ();
+    GString *events = g_string_new (NULL);
+
+    /* twice, the decoder keeps its buffers between payloads */
+    gint i;
+    for (i = 0; i < 2; i++)
+    {
+        g_string_truncate (events, 0);
+
+        gboolean parsed = gooroom_notice_json_decoder_parse (decoder, c->data, c->reply, &test_handler, events);
+
+        g_assert_cmpint (parsed, ==, c->parsed);
+        g_assert_cmpstr (events->str, ==, c->events);
+    }
+
+    g_string_free (events, TRUE);
+    gooroom_notice_json_decoder_free (decoder);
+}
+
+/* every proper prefix of a good payload is rejected and reports nothing */
+static void
+test_json_truncated (void)
+{
+    GooroomNoticeJsonDecoder *decoder = gooroom_notice_json_decoder_new ();
+    GString *events = g_string_new (NULL);
+    guint i;
+
+    for (i = 0; i < G_N_ELEMENTS (json_cases); i++)
+    {
+        const JsonCase *c = &json_cases[i];
+        gsize len = strlen (c->data);
+        gsize end;
+
+        if (!c->parsed)
+            continue;
+
+        /* trailing whitespace may go */
+        while (0 < len && g_ascii_isspace (c->data[len - 1]))
+            len--;
+
+        for (end = 0; end < len; end++)
+        {
+            gchar *prefix = g_strndup (c->data, end);
+
+            g_string_truncate (events, 0);
+            g_assert_false (gooroom_notice_json_decoder_parse (decoder, prefix, c->reply, &test_handler, events));
+            g_assert_cmpstr (events->str, ==, "");
+
+            g_free (prefix);
+        }
+
+        /* and the decoder is not left stuck on a partial value */
+        g_string_truncate (events, 0);
+        g_assert_true (gooroom_notice_json_decoder_parse (decoder, c->data, c->reply, &test_handler, events));
+        g_assert_cmpstr (events->str, ==, c->events);
+    }
+
+    g_string_free (events, TRUE);
+    gooroom_notice_json_decoder_free (decoder);
+}
+
+static gboolean
+test_json_nested (GooroomNoticeJsonDecoder *decoder, const gchar *open, const gchar *close, gint depth)
+{
+    GString *data = g_string_new ("{\"x\":");
+    GString *events = g_string_new (NULL);
+    gboolean parsed;
+    gint i;
+
+    for (i = 0; i < depth; i++)
+        g_string_append (data, open);
+    g_string_append (data, "1");
+    for (i = 0; i < depth; i++)
+        g_string_append (data, close);
+    g_string_append (data, ",\"disabled_title_view_cnt\":1}");
+
+    parsed = gooroom_notice_json_decoder_parse (decoder, data->str, FALSE, &test_handler, events);
+    g_assert_cmpstr (events->str, ==, parsed ? "disabled(1) " : "");
+
+    g_string_free (data, TRUE);
+    g_string_free (events, TRUE);
+
+    return parsed;
+}
+
+static void
+test_json_depth (void)
+{
+    GooroomNoticeJsonDecoder *decoder = gooroom_notice_json_decoder_new ();
+
+    g_assert_true (test_json_nested (decoder, "[", "]", 16));
+    g_assert_true (test_json_nested (decoder, "{\"a\":", "}", 16));
+
+    g_assert_false (test_json_nested (decoder, "[", "]", 1000));
+    g_assert_false (test_json_nested (decoder, "{\"a\":", "}", 1000));
+
+    gooroom_notice_json_decoder_free (decoder);
+}
+
+/* however the library maps a lone surrogate, only valid UTF-8 comes out */
+static void
+test_json_lone_surrogate (void)
+{
+    GooroomNoticeJsonDecoder *decoder = gooroom_notice_json_decoder_new ();
+    GString *events = g_string_new (NULL);
+    const gchar *data[] =
+    {
+        "{\"enabled_title_view_notis\":[{\"id\":\"1\",\"title\":\"\\ud800\"}]}",
+        "{\"enabled_title_view_notis\":[{\"id\":\"1\",\"title\":\"\\udc00x\"}]}",
+        "{\"enabled_title_view_notis\":[{\"id\":\"1\",\"title\":\"\\ud800\\u0041\"}]}",
+    };
+    guint i;
+
+    for (i = 0; i < G_N_ELEMENTS (data); i++)
+    {
+        g_string_truncate (events, 0);
+
+        if (gooroom_notice_json_decoder_parse (decoder, data[i], FALSE, &test_handler, events))
+            g_assert_true (g_utf8_validate (events->str, -1, NULL));
+        else
+            g_assert_cmpstr (events->str, ==, "");
+    }
+
+    g_string_free (events, TRUE);
+    gooroom_notice_json_decoder_free (decoder);
+}
+
+int
+main (int argc, char **argv)
+{
+    guint i;
+
+    g_test_init (&argc, &argv, NULL);
+
+    for (i = 0; i < G_N_ELEMENTS (json_cases); i++)
+    {
+        gchar *path = g_strdup_printf ("/json/%s", json_cases[i].name);
+        g_test_add_data_func (path, &json_cases[i], test_json_case);
+        g_free (path);
+    }
+
+    g_test_add_func ("/json/truncated", test_json_truncated);
+    g_test_add_func ("/json/depth", test_json_depth);
+    g_test_add_func ("/json/lone surrogate", test_json_lone_surrogate);
+
+    return g_test_run ();
+}
@@ -0,0 +1,266 @@
+/*
+ * Copyright (c) 2018 - 2019 Gooroom <gooroom@gooroom.kr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <string.h>
+
+#include <glib.h>
+
+#include <json-c/json.h>
+
+#include "gooroom-notice-json.h"
+
+#define NOTICE_JSON_MAX_DEPTH    (64)
+
+struct _GooroomNoticeJsonDecoder
+{
+    struct json_tokener *tok;
+};
+
+/*
+ * Strings, numbers and booleans as text; null, objects and arrays leave
+ * @out NULL. FALSE for a string that is not a UTF-8 C string.
+ */
+static gboolean
+json_text (json_object *obj, const gchar **out)
+{
+    *out = NULL;
+
+    switch (json_object_get_type (obj))
+    {
+        case json_type_string:
+            {
+                const gchar *str = json_object_get_string (obj);
+                gint len = json_object_get_string_len (obj);
+
+                if ((gint)strlen (str) != len || !g_utf8_validate (str, len, NULL))
+                    return FALSE;
+
+                *out = str;
+                return TRUE;
+            }
+        case json_type_boolean:
+        case json_type_int:
+        case json_type_double:
+            *out = json_object_get_string (obj);
+            return TRUE;
+        default:
+            return TRUE;
+    }
+}
+
+/*
+ * Walks noti_info in document order. Without @handler it only checks the
+ * strings it would report, so that a bad one rejects the whole payload.
+ */
+static gboolean
+json_decode_noti (json_object *noti, const NoticeJsonHandler *handler, gpointer user_data)
+{
+    const gchar *text;
+    gint i, len;
+
+    if (!json_object_is_type (noti, json_type_object))
+        return TRUE;
+
+    json_object_object_foreach (noti, key, value)
+    {
+        NoticeJsonField field;
+
+        if (strcmp (key, "enabled_title_view_notis") == 0)
+        {
+            if (!json_object_is_type (value, json_type_array))
+                continue;
+
+            len = json_object_array_length (value);
+            for (i = 0; i < len; i++)
+            {
+                json_object *item = json_object_array_get_idx (value, i);
+                const gchar *id = NULL, *title = NULL, *url = NULL;
+
+                if (!json_object_is_type (item, json_type_object))
+                    continue;
+
+                json_object_object_foreach (item, ikey, ivalue)
+                {
+                    const gchar **out;
+
+                    if (strcmp (ikey, "noti_id") == 0 || strcmp (ikey, "id") == 0)
+                        out = &id;
+                    else if (strcmp (ikey, "title") == 0)
+                        out = &title;
+                    else if (strcmp (ikey, "url") == 0)
+                        out = &url;
+                    else
+                        continue;
+
+                    if (!json_text (ivalue, out))
+                        return FALSE;
+                }
+
+                if (handler && handler->notice)
+                    handler->notice (id, title ? title : "", url, user_data);
+            }
+            continue;
+        }
+
+        if (strcmp (key, "retracted_notis") == 0)
+        {
+            if (!json_object_is_type (value, json_type_array))
+                continue;
+
+            len = json_object_array_length (value);
+            for (i = 0; i < len; i++)
+            {
+                if (!json_text (json_object_array_get_idx (value, i), &text))
+                    return FALSE;
+
+                if (text && handler && handler->retracted)
+                    handler->retracted (text, user_data);
+            }
+            continue;
+        }
+
+        if (strcmp (key, "disabled_title_view_cnt") == 0)
+        {
+            if (json_object_is_type (value, json_type_null) ||
+                json_object_is_type (value, json_type_object) ||
+                json_object_is_type (value, json_type_array))
+                continue;
+
+            if (handler && handler->disabled_cnt)
+                handler->disabled_cnt (json_object_get_int (value), user_data);
+            continue;
+        }
+
+        if (strcmp (key, "signing") == 0)
+            field = NOTICE_JSON_FIELD_SIGNING;
+        else if (strcmp (key, "client_id") == 0)
+            field = NOTICE_JSON_FIELD_CLIENT_ID;
+        else if (strcmp (key, "session_id") == 0)
+            field = NOTICE_JSON_FIELD_SESSION_ID;
+        else if (strcmp (key, "default_noti_domain") == 0)
+            field = NOTICE_JSON_FIELD_DEFAULT_DOMAIN;
+        else if (strcmp (key, "cursor") == 0)
+            field = NOTICE_JSON_FIELD_CURSOR;
+        else if (strcmp (key, "sync") == 0)
+            field = NOTICE_JSON_FIELD_SYNC;
+        else
+            continue;
+
+        if (!json_text (value, &text))
+            return FALSE;
+
+        if (text && handler && handler->field)
+            handler->field (field, text, user_data);
+    }
+
+    return TRUE;
+}
+
+/* module.task.out.noti_info when out.status is 200 */
+static json_object *
+json_reply_noti (json_object *root)
+{
+    json_object *module, *task, *out, *status, *noti;
+
+    if (!json_object_object_get_ex (root, "module", &module) ||
+        !json_object_object_get_ex (module, "task", &task) ||
+        !json_object_object_get_ex (task, "out", &out) ||
+        !json_object_object_get_ex (out, "status", &status) ||
+        !json_object_object_get_ex (out, "noti_info", &noti))
+        return NULL;
+
+    if (g_strcmp0 (json_object_get_string (status), "200") != 0)
+        return NULL;
+
+    return noti;
+}
+
+GooroomNoticeJsonDecoder *
+gooroom_notice_json_decoder_new (void)
+{
+    GooroomNoticeJsonDecoder *dec;
+    dec = g_new0 (GooroomNoticeJsonDecoder, 1);
+
+    dec->tok = json_tokener_new_ex (NOTICE_JSON_MAX_DEPTH);
+    json_tokener_set_flags (dec->tok, JSON_TOKENER_STRICT);
+
+    return dec;
+}
+
+void
+gooroom_notice_json_decoder_free (GooroomNoticeJsonDecoder *decoder)
+{
+    if (!decoder)
+        return;
+
+    json_tokener_free (decoder->tok);
+    g_free (decoder);
+}
+
+gboolean
+gooroom_notice_json_decoder_parse (GooroomNoticeJsonDecoder *decoder,
+                                   const gchar *data,
+                                   gboolean reply,
+                                   const NoticeJsonHandler *handler,
+                                   gpointer user_data)
+{
+    g_return_val_if_fail (decoder != NULL, FALSE);
+    g_return_val_if_fail (handler != NULL, FALSE);
+
+    if (!data)
+        return FALSE;
+
+    gsize len = strlen (data);
+    if (G_MAXINT < len)
+        return FALSE;
+
+    json_tokener_reset (decoder->tok);
+
+    json_object *root = json_tokener_parse_ex (decoder->tok, data, (gint)len);
+    if (!root)
+        return FALSE;
+
+    gboolean parsed = FALSE;
+
+    /* one value and nothing after it */
+    const gchar *rest = data + decoder->tok->char_offset;
+    rest += strspn (rest, " \t\n\r");
+
+    if (json_tokener_get_error (decoder->tok) != json_tokener_success || *rest != '\0')
+        goto out;
+
+    json_object *noti = reply ? json_reply_noti (root) : root;
+    if (!noti || json_object_is_type (noti, json_type_null))
+        goto out;
+
+    if (!json_decode_noti (noti, NULL, NULL))
+        goto out;
+
+    json_decode_noti (noti, handler, user_data);
+    parsed = TRUE;
+
+out:
+    json_object_put (root);
+
+    return parsed;
+}
@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2018-2019 Gooroom <gooroom@gooroom.kr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#ifndef __GOOROOM_NOTICE_JSON_H__
+#define __GOOROOM_NOTICE_JSON_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef enum
+{
+    NOTICE_JSON_FIELD_SIGNING,
+    NOTICE_JSON_FIELD_CLIENT_ID,
+    NOTICE_JSON_FIELD_SESSION_ID,
+    NOTICE_JSON_FIELD_DEFAULT_DOMAIN,
+    NOTICE_JSON_FIELD_CURSOR,
+    NOTICE_JSON_FIELD_SYNC
+} NoticeJsonField;
+
+typedef struct
+{
+    void (*notice)       (const gchar *id, const gchar *title, const gchar *url, gpointer user_data);
+    void (*field)        (NoticeJsonField field, const gchar *value, gpointer user_data);
+    void (*disabled_cnt) (gint cnt, gpointer user_data);
+    void (*retracted)    (const gchar *id, gpointer user_data);
+} NoticeJsonHandler;
+
+typedef struct _GooroomNoticeJsonDecoder GooroomNoticeJsonDecoder;
+
+GooroomNoticeJsonDecoder *gooroom_notice_json_decoder_new (void);
+void gooroom_notice_json_decoder_free (GooroomNoticeJsonDecoder *decoder);
+
+/*
+ * Parses an agent payload with the decoder's json_tokener, reset for
+ * each call, and reports the notice fields to @handler as borrowed
+ * strings. When @reply is TRUE, @data is a do_task reply and the fields
+ * are taken from module.task.out.noti_info provided out.status is 200;
+ * otherwise @data is a set_noti signal body. Nothing is reported and
+ * FALSE is returned for input the strict tokener rejects, anything but
+ * whitespace after the value, or a reported string that is not valid
+ * UTF-8 or contains \u0000.
+ *
+ * Agents that support delta sync add "cursor" and "sync" ("full" or
+ * "delta") to noti_info; a delta lists new and changed notices in
+ * enabled_title_view_notis and removed ones in retracted_notis.
+ */
+gboolean gooroom_notice_json_decoder_parse (GooroomNoticeJsonDecoder *decoder,
+                                            const gchar *data,
+                                            gboolean reply,
+                                            const NoticeJsonHandler *handler,
+                                            gpointer user_data);
+
+G_END_DECLS
+
+#endif /* __GOOROOM_NOTICE_JSON_H__*/
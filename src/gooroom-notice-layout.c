@@ -0,0 +1,241 @@
+/*
+ * Copyright (c) 2018 - 2019 Gooroom <gooroom@gooroom.kr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <string.h>
+
+#include <glib.h>
+#include <glib/gi18n.h>
+
+#include "gooroom-notice-layout.h"
+
+#define NOTICE_LAYOUT_ELLIPSIS   "..."
+#define NOTICE_LAYOUT_CACHE_SIZE (4096)
+#define NOTICE_LAYOUT_KEY_MAX    (32)
+#define NOTICE_LAYOUT_SUFFIX_MAX (128)
+
+struct _GooroomNoticeLayout
+{
+    GooroomNoticeMeasure  measure;
+    gpointer              measure_data;
+    gint                  max_width;
+
+    gint                  ellipsis_width;
+    gint                  ascii[128];
+    GHashTable           *runs;
+};
+
+GooroomNoticeLayout *
+gooroom_notice_layout_new (GooroomNoticeMeasure measure, gpointer user_data, gint max_width)
+{
+    GooroomNoticeLayout *layout;
+    layout = g_new0 (GooroomNoticeLayout, 1);
+
+    layout->measure = measure;
+    layout->measure_data = user_data;
+    layout->max_width = max_width;
+    layout->ellipsis_width = -1;
+    layout->runs = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+    memset (layout->ascii, -1, sizeof (layout->ascii));
+
+    return layout;
+}
+
+void
+gooroom_notice_layout_free (GooroomNoticeLayout *layout)
+{
+    if (!layout)
+        return;
+
+    g_hash_table_destroy (layout->runs);
+    g_free (layout);
+}
+
+void
+gooroom_notice_layout_reclaim (GooroomNoticeLayout *layout)
+{
+    g_hash_table_remove_all (layout->runs);
+
+    memset (layout->ascii, -1, sizeof (layout->ascii));
+    layout->ellipsis_width = -1;
+}
+
+static gboolean
+notice_layout_is_regional (gunichar c)
+{
+    return 0x1F1E6 <= c && c <= 0x1F1FF;
+}
+
+static gboolean
+notice_layout_is_hangul (gunichar c)
+{
+    return (0x1100 <= c && c <= 0x11FF) || (0xAC00 <= c && c <= 0xD7A3);
+}
+
+/*
+ * End of the grapheme cluster starting at @p. Covers what shows up in
+ * titles: combining marks, ZWJ sequences, emoji modifiers, flags,
+ * conjoining Hangul jamo and CR LF.
+ */
+static const gchar *
+notice_layout_next_cluster (const gchar *p, const gchar *end)
+{
+    gunichar prev = g_utf8_get_char (p);
+    guint regional = notice_layout_is_regional (prev) ? 1 : 0;
+
+    p = g_utf8_next_char (p);
+
+    while (p < end)
+    {
+        gunichar c = g_utf8_get_char (p);
+
+        if (prev == 0x200D || c == 0x200D || g_unichar_ismark (c))
+            ;
+        else if (0x1F3FB <= c && c <= 0x1F3FF)
+            ;
+        else if (prev == '\r' && c == '\n')
+            ;
+        else if (0x1160 <= c && c <= 0x11FF && notice_layout_is_hangul (prev))
+            ;
+        else if (regional % 2 == 1 && notice_layout_is_regional (c))
+            regional++;
+        else
+            break;
+
+        prev = c;
+        p = g_utf8_next_char (p);
+    }
+
+    return p;
+}
+
+static gint
+notice_layout_run_width (GooroomNoticeLayout *layout, const gchar *run, gsize len)
+{
+    gchar key[NOTICE_LAYOUT_KEY_MAX];
+    gpointer cached;
+    gint width;
+
+    if (!layout->measure)
+        return 1;
+
+    if (len == 1 && (guchar)run[0] < 128)
+    {
+        gint *ascii = &layout->ascii[(guchar)run[0]];
+
+        if (*ascii < 0)
+            *ascii = layout->measure (run, len, layout->measure_data);
+
+        return *ascii;
+    }
+
+    if (NOTICE_LAYOUT_KEY_MAX <= len)
+        return layout->measure (run, len, layout->measure_data);
+
+    memcpy (key, run, len);
+    key[len] = '\0';
+
+    cached = g_hash_table_lookup (layout->runs, key);
+    if (cached)
+        return GPOINTER_TO_INT (cached) - 1;
+
+    width = layout->measure (run, len, layout->measure_data);
+
+    if (NOTICE_LAYOUT_CACHE_SIZE <= g_hash_table_size (layout->runs))
+        g_hash_table_remove_all (layout->runs);
+
+    g_hash_table_insert (layout->runs, g_strndup (run, len), GINT_TO_POINTER (width + 1));
+
+    return width;
+}
+
+static gint
+notice_layout_ellipsis_width (GooroomNoticeLayout *layout)
+{
+    if (layout->ellipsis_width < 0)
+    {
+        layout->ellipsis_width = 0;
+        if (layout->measure)
+            layout->ellipsis_width = layout->measure (NOTICE_LAYOUT_ELLIPSIS, strlen (NOTICE_LAYOUT_ELLIPSIS), layout->measure_data);
+    }
+
+    return layout->ellipsis_width;
+}
+
+gchar *
+gooroom_notice_layout_title (GooroomNoticeLayout *layout, const gchar *text, gint other_cnt)
+{
+    gchar suffix[NOTICE_LAYOUT_SUFFIX_MAX];
+    gsize suffix_len = 0;
+
+    if (!text)
+        text = "";
+
+    while (*text && g_ascii_isspace (*text))
+        text++;
+
+    const gchar *end = text + strlen (text);
+    while (text < end && g_ascii_isspace (end[-1]))
+        end--;
+
+    /* the last boundary that still leaves room for the ellipsis */
+    gint budget = layout->max_width - notice_layout_ellipsis_width (layout);
+    const gchar *cut = text;
+    const gchar *p = text;
+    gint width = 0;
+
+    while (p < end)
+    {
+        const gchar *next = notice_layout_next_cluster (p, end);
+
+        width += notice_layout_run_width (layout, p, next - p);
+        if (layout->max_width < width)
+            break;
+
+        p = next;
+        if (width <= budget)
+            cut = p;
+    }
+
+    gboolean ellipsized = (p < end);
+    if (!ellipsized)
+        cut = end;
+
+    if (other_cnt != 0)
+    {
+        suffix[0] = ' ';
+        suffix_len = 1 + g_snprintf (suffix + 1, sizeof (suffix) - 1, _("other %d cases"), other_cnt);
+        suffix_len = MIN (suffix_len, sizeof (suffix) - 1);
+    }
+
+    gsize len = cut - text;
+    gsize ellipsis_len = ellipsized ? strlen (NOTICE_LAYOUT_ELLIPSIS) : 0;
+    gchar *title = g_malloc (len + ellipsis_len + suffix_len + 1);
+
+    memcpy (title, text, len);
+    memcpy (title + len, NOTICE_LAYOUT_ELLIPSIS, ellipsis_len);
+    memcpy (title + len + ellipsis_len, suffix, suffix_len);
+    title[len + ellipsis_len + suffix_len] = '\0';
+
+    return title;
+}
@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) 2018-2019 Gooroom <gooroom@gooroom.kr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#ifndef __GOOROOM_NOTICE_LAYOUT_H__
+#define __GOOROOM_NOTICE_LAYOUT_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* rendered width of @len bytes of @text, in pixels */
+typedef gint (*GooroomNoticeMeasure) (const gchar *text, gsize len, gpointer user_data);
+
+typedef struct _GooroomNoticeLayout GooroomNoticeLayout;
+
+/*
+ * Fits notice titles into @max_width. Titles are cut on grapheme
+ * cluster boundaries and the width of each cluster is measured once
+ * and cached, so laying out a backlog mostly costs hash lookups.
+ * Kerning between clusters is not accounted for.
+ *
+ * Without @measure every cluster counts as 1 and the ellipsis as 0,
+ * i.e. @max_width is a cluster count.
+ */
+GooroomNoticeLayout *gooroom_notice_layout_new (GooroomNoticeMeasure measure, gpointer user_data, gint max_width);
+void gooroom_notice_layout_free (GooroomNoticeLayout *layout);
+
+/* forgets measured widths; they are measured again as needed */
+void gooroom_notice_layout_reclaim (GooroomNoticeLayout *layout);
+
+/*
+ * Returns a newly allocated title: @text with surrounding whitespace
+ * stripped, ellipsized to the layout width, followed by
+ * "other @other_cnt cases" unless @other_cnt is 0.
+ */
+gchar *gooroom_notice_layout_title (GooroomNoticeLayout *layout, const gchar *text, gint other_cnt);
+
+G_END_DECLS
+
+#endif /* __GOOROOM_NOTICE_LAYOUT_H__*/
@@ -0,0 +1,492 @@
+/*
+ * Copyright (c) 2018 - 2019 Gooroom <gooroom@gooroom.kr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include "gooroom-notice-log.h"
+
+#define NOTICE_LOG_RING_SIZE      (1024)
+#define NOTICE_LOG_BATCH          (NOTICE_LOG_RING_SIZE / 4)
+#define NOTICE_LOG_FLUSH_INTERVAL (G_TIME_SPAN_SECOND)
+#define NOTICE_LOG_VALUE_MAX      (1024)
+
+typedef struct
+{
+    gint64          time;
+    GLogLevelFlags  level;
+    gchar          *line;
+}NoticeLogEntry;
+
+typedef struct
+{
+    GMutex          lock;
+    GCond           cond;
+    NoticeLogEntry  ring[NOTICE_LOG_RING_SIZE];
+    guint64         head;
+    guint64         flushed;
+    guint64         dropped;
+    gboolean        wake;
+    gboolean        dump;
+    gboolean        quit;
+
+    GLogLevelFlags  levels;
+
+    /* held while the file is written, taken before lock */
+    GMutex          write_lock;
+    gchar          *path;
+    FILE           *file;
+    gsize           size;
+    gsize           max_size;
+    guint           files;
+
+    GThread        *thread;
+}NoticeLog;
+
+static NoticeLog *notice_log = NULL;
+
+static GLogLevelFlags
+notice_log_levels_from_severity (gint level)
+{
+    GLogLevelFlags levels = G_LOG_LEVEL_ERROR | G_LOG_LEVEL_CRITICAL;
+
+    if (4 <= level)
+        levels |= G_LOG_LEVEL_WARNING;
+    if (5 <= level)
+        levels |= G_LOG_LEVEL_MESSAGE;
+    if (6 <= level)
+        levels |= G_LOG_LEVEL_INFO;
+    if (7 <= level)
+        levels |= G_LOG_LEVEL_DEBUG;
+
+    return levels;
+}
+
+static const gchar *
+notice_log_level_name (GLogLevelFlags level)
+{
+    if (level & G_LOG_LEVEL_ERROR)
+        return "error";
+    if (level & G_LOG_LEVEL_CRITICAL)
+        return "critical";
+    if (level & G_LOG_LEVEL_WARNING)
+        return "warning";
+    if (level & G_LOG_LEVEL_MESSAGE)
+        return "message";
+    if (level & G_LOG_LEVEL_INFO)
+        return "info";
+
+    return "debug";
+}
+
+/* quoted, capped at NOTICE_LOG_VALUE_MAX bytes so long values stay cheap */
+static void
+notice_log_append_value (GString *line, const gchar *value)
+{
+    gsize len = value ? strlen (value) : 0;
+    gsize cut, i;
+
+    /* most callers end their messages with a newline */
+    while (0 < len && value[len - 1] == '\n')
+        len--;
+
+    cut = len;
+    if (NOTICE_LOG_VALUE_MAX < cut)
+    {
+        cut = NOTICE_LOG_VALUE_MAX;
+        while (0 < cut && ((guchar)value[cut] & 0xC0) == 0x80)
+            cut--;
+    }
+
+    g_string_append_c (line, '"');
+    for (i = 0; i < cut; i++)
+    {
+        switch (value[i])
+        {
+            case '"':
+            case '\\':
+                g_string_append_c (line, '\\');
+                g_string_append_c (line, value[i]);
+                break;
+            case '\n':
+                g_string_append (line, "\\n");
+                break;
+            default:
+                g_string_append_c (line, value[i]);
+                break;
+        }
+    }
+
+    if (cut < len)
+        g_string_append_printf (line, "...(+%" G_GSIZE_FORMAT " bytes)", len - cut);
+
+    g_string_append_c (line, '"');
+}
+
+static void
+notice_log_format_entry (GString *out, NoticeLogEntry *entry, gint64 *second, gchar **stamp)
+{
+    gint64 sec = entry->time / G_USEC_PER_SEC;
+
+    if (sec != *second)
+    {
+        GDateTime *dt = g_date_time_new_from_unix_local (sec);
+
+        g_free (*stamp);
+        *stamp = g_date_time_format (dt, "%Y-%m-%dT%H:%M:%S");
+        *second = sec;
+        g_date_time_unref (dt);
+    }
+
+    g_string_append_printf (out, "ts=%s.%06d %s\n", *stamp, (gint)(entry->time % G_USEC_PER_SEC), entry->line);
+}
+
+static void
+notice_log_rotate (NoticeLog *log)
+{
+    guint i;
+
+    fclose (log->file);
+    log->file = NULL;
+    log->size = 0;
+
+    for (i = log->files; 1 < i; i--)
+    {
+        gchar *from = g_strdup_printf ("%s.%u", log->path, i - 1);
+        gchar *to = g_strdup_printf ("%s.%u", log->path, i);
+
+        g_rename (from, to);
+        g_free (from);
+        g_free (to);
+    }
+
+    if (0 < log->files)
+    {
+        gchar *to = g_strdup_printf ("%s.1", log->path);
+        g_rename (log->path, to);
+        g_free (to);
+    }
+    else
+    {
+        g_unlink (log->path);
+    }
+}
+
+static void
+notice_log_write (NoticeLog *log, const gchar *data, gsize len)
+{
+    if (log->file && 0 < log->max_size && log->max_size <= log->size)
+        notice_log_rotate (log);
+
+    if (!log->file)
+    {
+        log->file = g_fopen (log->path, "a");
+        if (!log->file)
+            return;
+
+        fseek (log->file, 0, SEEK_END);
+        log->size = MAX (ftell (log->file), 0);
+    }
+
+    fwrite (data, 1, len, log->file);
+    fflush (log->file);
+    log->size += len;
+}
+
+static void
+notice_log_flush (NoticeLog *log)
+{
+    GString *batch = g_string_sized_new (4096);
+    gchar *stamp = NULL;
+    gint64 second = -1;
+
+    g_mutex_lock (&log->write_lock);
+    g_mutex_lock (&log->lock);
+
+    if (log->dropped)
+    {
+        g_string_append_printf (batch, "level=warning msg=\"log ring overrun, %" G_GUINT64_FORMAT " messages lost\"\n", log->dropped);
+        log->dropped = 0;
+    }
+
+    for (; log->flushed < log->head; log->flushed++)
+    {
+        notice_log_format_entry (batch, &log->ring[log->flushed % NOTICE_LOG_RING_SIZE], &second, &stamp);
+    }
+
+    g_mutex_unlock (&log->lock);
+
+    if (batch->len)
+        notice_log_write (log, batch->str, batch->len);
+
+    g_mutex_unlock (&log->write_lock);
+
+    g_free (stamp);
+    g_string_free (batch, TRUE);
+}
+
+static void
+notice_log_write_dump (NoticeLog *log)
+{
+    GString *out = g_string_sized_new (NOTICE_LOG_RING_SIZE * 128);
+    gchar *stamp = NULL;
+    gint64 second = -1;
+    guint64 seq;
+
+    g_mutex_lock (&log->lock);
+
+    seq = (log->head < NOTICE_LOG_RING_SIZE) ? 0 : log->head - NOTICE_LOG_RING_SIZE;
+    for (; seq < log->head; seq++)
+        notice_log_format_entry (out, &log->ring[seq % NOTICE_LOG_RING_SIZE], &second, &stamp);
+
+    g_mutex_unlock (&log->lock);
+
+    gchar *path = g_strconcat (log->path, ".dump", NULL);
+    g_file_set_contents (path, out->str, out->len, NULL);
+
+    g_free (path);
+    g_free (stamp);
+    g_string_free (out, TRUE);
+}
+
+static gpointer
+notice_log_thread (gpointer data)
+{
+    NoticeLog *log = (NoticeLog *)data;
+
+    g_mutex_lock (&log->lock);
+
+    while (!log->quit)
+    {
+        gint64 deadline = 0;
+
+        while (!log->quit && !log->wake && !log->dump)
+        {
+            if (log->head == log->flushed)
+            {
+                g_cond_wait (&log->cond, &log->lock);
+                continue;
+            }
+
+            if (!deadline)
+                deadline = g_get_monotonic_time () + NOTICE_LOG_FLUSH_INTERVAL;
+
+            if (!g_cond_wait_until (&log->cond, &log->lock, deadline))
+                break;
+        }
+
+        gboolean dump = log->dump;
+        log->wake = FALSE;
+        log->dump = FALSE;
+
+        g_mutex_unlock (&log->lock);
+
+        notice_log_flush (log);
+        if (dump)
+            notice_log_write_dump (log);
+
+        g_mutex_lock (&log->lock);
+    }
+
+    g_mutex_unlock (&log->lock);
+
+    notice_log_flush (log);
+
+    return NULL;
+}
+
+static void
+notice_log_push (NoticeLog *log, GLogLevelFlags level, gchar *line)
+{
+    gint64 now = g_get_real_time ();
+
+    g_mutex_lock (&log->lock);
+
+    NoticeLogEntry *entry = &log->ring[log->head % NOTICE_LOG_RING_SIZE];
+
+    /* the writer fell a full ring behind, the oldest pending entry goes */
+    if (log->head - log->flushed == NOTICE_LOG_RING_SIZE)
+    {
+        log->dropped++;
+        log->flushed++;
+    }
+
+    g_free (entry->line);
+    entry->time = now;
+    entry->level = level;
+    entry->line = line;
+
+    if (log->head++ == log->flushed)
+        g_cond_signal (&log->cond);
+
+    if ((level & (G_LOG_LEVEL_ERROR | G_LOG_LEVEL_CRITICAL | G_LOG_LEVEL_WARNING)) ||
+        NOTICE_LOG_BATCH <= log->head - log->flushed)
+    {
+        log->wake = TRUE;
+        g_cond_signal (&log->cond);
+    }
+
+    g_mutex_unlock (&log->lock);
+}
+
+static GString *
+notice_log_line_new (GLogLevelFlags log_level, const gchar *log_domain, const gchar *message)
+{
+    GString *line = g_string_sized_new (128);
+
+    g_string_append_printf (line, "level=%s", notice_log_level_name (log_level));
+    if (log_domain)
+        g_string_append_printf (line, " domain=%s", log_domain);
+
+    g_string_append (line, " msg=");
+    notice_log_append_value (line, message);
+
+    return line;
+}
+
+void
+gooroom_notice_log_handler (const gchar *log_domain,
+                            GLogLevelFlags log_level,
+                            const gchar *message,
+                            gpointer user_data)
+{
+    NoticeLog *log = g_atomic_pointer_get (&notice_log);
+
+    if (!log)
+    {
+        g_log_default_handler (log_domain, log_level, message, user_data);
+        return;
+    }
+
+    /* filtered before formatting so that debug calls cost nothing in production */
+    if (!(log_level & log->levels))
+        return;
+
+    GString *line = notice_log_line_new (log_level, log_domain, message);
+    notice_log_push (log, log_level, g_string_free (line, FALSE));
+
+    /* the process is about to abort, do not leave it to the thread */
+    if (log_level & (G_LOG_FLAG_FATAL | G_LOG_LEVEL_ERROR))
+        notice_log_flush (log);
+}
+
+void
+gooroom_notice_log_fields (GLogLevelFlags log_level, const gchar *message, ...)
+{
+    NoticeLog *log = g_atomic_pointer_get (&notice_log);
+    const gchar *key;
+    va_list args;
+
+    if (!log)
+    {
+        g_log (NULL, log_level, "%s", message);
+        return;
+    }
+
+    if (!(log_level & log->levels))
+        return;
+
+    GString *line = notice_log_line_new (log_level, NULL, message);
+
+    va_start (args, message);
+    while ((key = va_arg (args, const gchar *)))
+    {
+        const gchar *value = va_arg (args, const gchar *);
+
+        g_string_append_printf (line, " %s=", key);
+        notice_log_append_value (line, value);
+    }
+    va_end (args);
+
+    notice_log_push (log, log_level, g_string_free (line, FALSE));
+}
+
+void
+gooroom_notice_log_dump (void)
+{
+    NoticeLog *log = g_atomic_pointer_get (&notice_log);
+
+    if (!log)
+        return;
+
+    g_mutex_lock (&log->lock);
+    log->dump = TRUE;
+    g_cond_signal (&log->cond);
+    g_mutex_unlock (&log->lock);
+}
+
+void
+gooroom_notice_log_open (const gchar *path, gint level, gsize max_size, guint files)
+{
+    g_return_if_fail (path != NULL);
+    g_return_if_fail (notice_log == NULL);
+
+    NoticeLog *log = g_new0 (NoticeLog, 1);
+
+    g_mutex_init (&log->lock);
+    g_mutex_init (&log->write_lock);
+    g_cond_init (&log->cond);
+
+    log->path     = g_strdup (path);
+    log->levels   = notice_log_levels_from_severity (level);
+    log->max_size = max_size;
+    log->files    = files;
+    log->thread   = g_thread_new ("notice-log", notice_log_thread, log);
+
+    g_atomic_pointer_set (&notice_log, log);
+}
+
+void
+gooroom_notice_log_close (void)
+{
+    NoticeLog *log = g_atomic_pointer_get (&notice_log);
+    guint i;
+
+    if (!log)
+        return;
+
+    g_atomic_pointer_set (&notice_log, NULL);
+
+    g_mutex_lock (&log->lock);
+    log->quit = TRUE;
+    g_cond_signal (&log->cond);
+    g_mutex_unlock (&log->lock);
+
+    g_thread_join (log->thread);
+
+    if (log->file)
+        fclose (log->file);
+
+    for (i = 0; i < NOTICE_LOG_RING_SIZE; i++)
+        g_free (log->ring[i].line);
+
+    g_cond_clear (&log->cond);
+    g_mutex_clear (&log->write_lock);
+    g_mutex_clear (&log->lock);
+    g_free (log->path);
+    g_free (log);
+}
@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) 2018-2019 Gooroom <gooroom@gooroom.kr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#ifndef __GOOROOM_NOTICE_LOG_H__
+#define __GOOROOM_NOTICE_LOG_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/*
+ * Process-wide buffered logger. Messages at or above the file level are
+ * formatted into an in-memory ring on the calling thread and a
+ * background thread appends them to the log file in batches, rotating
+ * it by size. Messages below the level are dropped before formatting.
+ * gooroom_notice_log_dump() writes the recent history kept in the ring.
+ *
+ * @level follows syslog severities: 3 error, 4 warning, 5 message,
+ * 6 info, 7 debug. @max_size is in bytes, @files is the number of
+ * rotated files kept next to @path.
+ */
+void gooroom_notice_log_open (const gchar *path, gint level, gsize max_size, guint files);
+void gooroom_notice_log_close (void);
+
+/* GLogFunc, install with g_log_set_handler() */
+void gooroom_notice_log_handler (const gchar *log_domain, GLogLevelFlags log_level, const gchar *message, gpointer user_data);
+
+/* logs @message with NULL-terminated key/value string pairs */
+void gooroom_notice_log_fields (GLogLevelFlags log_level, const gchar *message, ...) G_GNUC_NULL_TERMINATED;
+
+/* writes the whole ring to "<path>.dump"; safe to call from a signal source */
+void gooroom_notice_log_dump (void);
+
+G_END_DECLS
+
+#endif /* __GOOROOM_NOTICE_LOG_H__*/
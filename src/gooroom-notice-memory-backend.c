@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) 2018 - 2019 Gooroom <gooroom@gooroom.kr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <glib.h>
+
+#include "gooroom-notice-memory-backend.h"
+
+struct _GooroomNoticeMemoryBackend
+{
+    GooroomNoticeCore *core;
+
+    GPtrArray   *on_screen;
+    guint        serial;
+
+    guint        shown;
+    guint        status_changes;
+    guint        viewer_opens;
+    guint        requests;
+
+    GooroomNoticeIndicatorStatus status;
+};
+
+static gpointer
+memory_notification_show (const gchar *title, const gchar *icon, GooroomNoticeUrgency urgency, gpointer user_data)
+{
+    GooroomNoticeMemoryBackend *backend = (GooroomNoticeMemoryBackend *)user_data;
+
+    /* handles only have to be unique and non-NULL */
+    gpointer notification = GUINT_TO_POINTER (++backend->serial);
+
+    g_ptr_array_add (backend->on_screen, notification);
+    backend->shown++;
+
+    return notification;
+}
+
+static void
+memory_notification_close (gpointer notification, gpointer user_data)
+{
+    GooroomNoticeMemoryBackend *backend = (GooroomNoticeMemoryBackend *)user_data;
+
+    g_ptr_array_remove_fast (backend->on_screen, notification);
+}
+
+static void
+memory_indicator_set_status (GooroomNoticeIndicatorStatus status, gpointer user_data)
+{
+    GooroomNoticeMemoryBackend *backend = (GooroomNoticeMemoryBackend *)user_data;
+
+    if (backend->status == status)
+        return;
+
+    backend->status = status;
+    backend->status_changes++;
+}
+
+static void
+memory_viewer_open (const gchar *url, const GooroomNoticeSession *session, gpointer user_data)
+{
+    GooroomNoticeMemoryBackend *backend = (GooroomNoticeMemoryBackend *)user_data;
+
+    backend->viewer_opens++;
+}
+
+static void
+memory_agent_request (const gchar *request, gpointer user_data)
+{
+    GooroomNoticeMemoryBackend *backend = (GooroomNoticeMemoryBackend *)user_data;
+
+    backend->requests++;
+}
+
+static const GooroomNoticeBackend memory_backend =
+{
+    memory_notification_show,
+    memory_notification_close,
+    memory_indicator_set_status,
+    memory_viewer_open,
+    memory_agent_request,
+    NULL,
+    NULL
+};
+
+GooroomNoticeMemoryBackend*
+gooroom_notice_memory_backend_new (void)
+{
+    GooroomNoticeMemoryBackend *backend = g_new0 (GooroomNoticeMemoryBackend, 1);
+
+    backend->on_screen = g_ptr_array_new ();
+    backend->status = GOOROOM_NOTICE_INDICATOR_PASSIVE;
+
+    return backend;
+}
+
+void
+gooroom_notice_memory_backend_free (GooroomNoticeMemoryBackend *backend)
+{
+    if (!backend)
+        return;
+
+    g_ptr_array_free (backend->on_screen, TRUE);
+    g_free (backend);
+}
+
+GooroomNoticeCore*
+gooroom_notice_memory_backend_attach (GooroomNoticeMemoryBackend *backend)
+{
+    backend->core = gooroom_notice_core_new (&memory_backend, backend);
+    return backend->core;
+}
+
+/* the notification daemon expiring everything that is on screen */
+void
+gooroom_notice_memory_backend_close_all (GooroomNoticeMemoryBackend *backend)
+{
+    while (0 < backend->on_screen->len)
+    {
+        gpointer notification = g_ptr_array_remove_index_fast (backend->on_screen, backend->on_screen->len - 1);
+
+        if (backend->core)
+            gooroom_notice_core_notification_closed (backend->core, notification);
+    }
+}
+
+guint
+gooroom_notice_memory_backend_shown (GooroomNoticeMemoryBackend *backend)
+{
+    return backend->shown;
+}
+
+guint
+gooroom_notice_memory_backend_status_changes (GooroomNoticeMemoryBackend *backend)
+{
+    return backend->status_changes;
+}
+
+guint
+gooroom_notice_memory_backend_viewer_opens (GooroomNoticeMemoryBackend *backend)
+{
+    return backend->viewer_opens;
+}
+
+guint
+gooroom_notice_memory_backend_requests (GooroomNoticeMemoryBackend *backend)
+{
+    return backend->requests;
+}
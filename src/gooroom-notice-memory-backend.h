@@ -0,0 +1,50 @@
+/*
+ * Copyright (C) 2018-2019 Gooroom <gooroom@gooroom.kr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#ifndef __GOOROOM_NOTICE_MEMORY_BACKEND_H__
+#define __GOOROOM_NOTICE_MEMORY_BACKEND_H__
+
+#include <glib.h>
+
+#include "gooroom-notice-core.h"
+
+G_BEGIN_DECLS
+
+/*
+ * A backend that keeps everything in memory: notifications stay "on
+ * screen" until gooroom_notice_memory_backend_close_all() expires them,
+ * and indicator, viewer and agent requests are only counted.
+ */
+typedef struct _GooroomNoticeMemoryBackend GooroomNoticeMemoryBackend;
+
+GooroomNoticeMemoryBackend *gooroom_notice_memory_backend_new (void);
+void gooroom_notice_memory_backend_free (GooroomNoticeMemoryBackend *backend);
+
+/* creates a core wired to @backend; the caller unrefs it before freeing @backend */
+GooroomNoticeCore *gooroom_notice_memory_backend_attach (GooroomNoticeMemoryBackend *backend);
+
+void  gooroom_notice_memory_backend_close_all (GooroomNoticeMemoryBackend *backend);
+guint gooroom_notice_memory_backend_shown (GooroomNoticeMemoryBackend *backend);
+guint gooroom_notice_memory_backend_status_changes (GooroomNoticeMemoryBackend *backend);
+guint gooroom_notice_memory_backend_viewer_opens (GooroomNoticeMemoryBackend *backend);
+guint gooroom_notice_memory_backend_requests (GooroomNoticeMemoryBackend *backend);
+
+G_END_DECLS
+
+#endif /* __GOOROOM_NOTICE_MEMORY_BACKEND_H__*/
@@ -0,0 +1,370 @@
+/*
+ * Copyright (c) 2018 - 2019 Gooroom <gooroom@gooroom.kr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <gio/gio.h>
+
+#include "gooroom-notice-pages.h"
+
+#define NOTICE_PAGES_SUFFIX ".mhtml"
+
+typedef struct
+{
+    gchar   *name;
+    guint64  size;
+    GList    link;
+}PageEntry;
+
+struct _GooroomNoticePages
+{
+    gchar        *dir;
+    guint64       budget;
+    guint64       size;
+
+    GHashTable   *entries;
+    GQueue        lru;
+
+    GCancellable *cancellable;
+};
+
+typedef struct
+{
+    GooroomNoticePages *pages;
+    GCancellable       *cancellable;
+    gchar              *name;
+    GInputStream       *stream;
+}PageStore;
+
+typedef struct
+{
+    gchar   *name;
+    guint64  size;
+    guint64  mtime;
+}PageFound;
+
+static void
+page_entry_free (gpointer data)
+{
+    PageEntry *entry = (PageEntry *)data;
+
+    g_free (entry->name);
+    g_free (entry);
+}
+
+static gchar*
+gooroom_notice_pages_name (const gchar *url)
+{
+    g_autofree gchar *digest = g_compute_checksum_for_string (G_CHECKSUM_SHA1, url, -1);
+    return g_strconcat (digest, NOTICE_PAGES_SUFFIX, NULL);
+}
+
+static void
+gooroom_notice_pages_evict (GooroomNoticePages *pages)
+{
+    while (pages->budget < pages->size && !g_queue_is_empty (&pages->lru))
+    {
+        GList *link = g_queue_pop_head_link (&pages->lru);
+        PageEntry *entry = link->data;
+
+        g_autofree gchar *path = g_build_filename (pages->dir, entry->name, NULL);
+        g_autoptr(GFile) file = g_file_new_for_path (path);
+        g_file_delete_async (file, G_PRIORITY_LOW, NULL, NULL, NULL);
+
+        pages->size -= entry->size;
+        g_hash_table_remove (pages->entries, entry->name);
+    }
+}
+
+/* adds or resizes the copy called @name and makes it the most recent */
+static void
+gooroom_notice_pages_account (GooroomNoticePages *pages, const gchar *name, guint64 size)
+{
+    PageEntry *entry = g_hash_table_lookup (pages->entries, name);
+
+    if (entry)
+    {
+        g_queue_unlink (&pages->lru, &entry->link);
+        pages->size -= entry->size;
+    }
+    else
+    {
+        entry = g_new0 (PageEntry, 1);
+        entry->name = g_strdup (name);
+        entry->link.data = entry;
+        g_hash_table_insert (pages->entries, entry->name, entry);
+    }
+
+    entry->size = size;
+    pages->size += size;
+    g_queue_push_tail_link (&pages->lru, &entry->link);
+}
+
+static gint
+page_found_compare (gconstpointer a, gconstpointer b)
+{
+    const PageFound *fa = *(const PageFound **)a;
+    const PageFound *fb = *(const PageFound **)b;
+
+    return (fa->mtime > fb->mtime) - (fa->mtime < fb->mtime);
+}
+
+static void
+page_found_free (gpointer data)
+{
+    PageFound *found = (PageFound *)data;
+
+    g_free (found->name);
+    g_free (found);
+}
+
+static void
+gooroom_notice_pages_scan_thread (GTask *task, gpointer source, gpointer task_data, GCancellable *cancellable)
+{
+    const gchar *dir_path = (const gchar *)task_data;
+    gint64 started = g_get_real_time () / G_USEC_PER_SEC;
+    GPtrArray *found = g_ptr_array_new_with_free_func (page_found_free);
+
+    g_mkdir_with_parents (dir_path, 0700);
+
+    GDir *dir = g_dir_open (dir_path, 0, NULL);
+    if (dir)
+    {
+        const gchar *name;
+        while ((name = g_dir_read_name (dir)))
+        {
+            g_autofree gchar *path = g_build_filename (dir_path, name, NULL);
+            GStatBuf st;
+
+            if (g_stat (path, &st) != 0 || !S_ISREG (st.st_mode))
+                continue;
+
+            if (!g_str_has_suffix (name, NOTICE_PAGES_SUFFIX))
+            {
+                /* leftovers of a write that never finished */
+                if (st.st_mtime < started)
+                    g_unlink (path);
+                continue;
+            }
+
+            PageFound *f = g_new0 (PageFound, 1);
+            f->name = g_strdup (name);
+            f->size = st.st_size;
+            f->mtime = st.st_mtime;
+            g_ptr_array_add (found, f);
+        }
+        g_dir_close (dir);
+    }
+
+    g_ptr_array_sort (found, page_found_compare);
+    g_task_return_pointer (task, found, (GDestroyNotify)g_ptr_array_unref);
+}
+
+static void
+gooroom_notice_pages_scan_done (GObject *source_object, GAsyncResult *res, gpointer user_data)
+{
+    GooroomNoticePages *pages = (GooroomNoticePages *)user_data;
+
+    g_autoptr(GError) error = NULL;
+    GPtrArray *found = g_task_propagate_pointer (G_TASK (res), &error);
+    if (!found)
+        return;
+
+    /* newest first, each one older than everything already known */
+    guint i;
+    for (i = found->len; 0 < i; i--)
+    {
+        PageFound *f = g_ptr_array_index (found, i - 1);
+
+        /* a copy stored while scanning is newer than what is on disk */
+        if (g_hash_table_contains (pages->entries, f->name))
+            continue;
+
+        gooroom_notice_pages_account (pages, f->name, f->size);
+
+        PageEntry *entry = g_hash_table_lookup (pages->entries, f->name);
+        g_queue_unlink (&pages->lru, &entry->link);
+        g_queue_push_head_link (&pages->lru, &entry->link);
+    }
+    g_ptr_array_unref (found);
+
+    g_debug ("gooroom_notice_pages_scan_done : %u pages, %" G_GUINT64_FORMAT " bytes\n",
+             g_hash_table_size (pages->entries), pages->size);
+
+    gooroom_notice_pages_evict (pages);
+}
+
+GooroomNoticePages *
+gooroom_notice_pages_new (const gchar *dir, guint64 budget)
+{
+    g_return_val_if_fail (dir != NULL, NULL);
+
+    GooroomNoticePages *pages;
+    pages = g_new0 (GooroomNoticePages, 1);
+    pages->dir = g_strdup (dir);
+    pages->budget = budget;
+    pages->entries = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, page_entry_free);
+    pages->cancellable = g_cancellable_new ();
+    g_queue_init (&pages->lru);
+
+    GTask *task = g_task_new (NULL, pages->cancellable, gooroom_notice_pages_scan_done, pages);
+    g_task_set_priority (task, G_PRIORITY_LOW);
+    g_task_set_return_on_cancel (task, TRUE);
+    g_task_set_task_data (task, g_strdup (dir), g_free);
+    g_task_run_in_thread (task, gooroom_notice_pages_scan_thread);
+    g_object_unref (task);
+
+    return pages;
+}
+
+void
+gooroom_notice_pages_free (GooroomNoticePages *pages)
+{
+    if (!pages)
+        return;
+
+    /* pending callbacks see the cancellation and leave @pages alone */
+    g_cancellable_cancel (pages->cancellable);
+    g_object_unref (pages->cancellable);
+
+    g_hash_table_destroy (pages->entries);
+    g_free (pages->dir);
+    g_free (pages);
+}
+
+gchar *
+gooroom_notice_pages_lookup (GooroomNoticePages *pages, const gchar *url)
+{
+    g_return_val_if_fail (url != NULL, NULL);
+
+    g_autofree gchar *name = gooroom_notice_pages_name (url);
+    PageEntry *entry = g_hash_table_lookup (pages->entries, name);
+    if (!entry)
+        return NULL;
+
+    g_queue_unlink (&pages->lru, &entry->link);
+    g_queue_push_tail_link (&pages->lru, &entry->link);
+
+    g_autofree gchar *path = g_build_filename (pages->dir, name, NULL);
+    g_autoptr(GFile) file = g_file_new_for_path (path);
+    g_autoptr(GFileInfo) info = g_file_info_new ();
+
+    g_file_info_set_attribute_uint64 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED, g_get_real_time () / G_USEC_PER_SEC);
+    g_file_set_attributes_async (file, info, G_FILE_QUERY_INFO_NONE, G_PRIORITY_LOW, NULL, NULL, NULL);
+
+    return g_filename_to_uri (path, NULL, NULL);
+}
+
+static void
+page_store_free (PageStore *store)
+{
+    g_free (store->name);
+    g_object_unref (store->cancellable);
+    g_object_unref (store->stream);
+    g_free (store);
+}
+
+static void
+gooroom_notice_pages_splice_done (GObject *source_object, GAsyncResult *res, gpointer user_data)
+{
+    PageStore *store = (PageStore *)user_data;
+
+    g_autoptr(GError) error = NULL;
+    gssize written = g_output_stream_splice_finish (G_OUTPUT_STREAM (source_object), res, &error);
+
+    if (written < 0)
+    {
+        if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+            g_debug ("gooroom_notice_pages_splice_done : %s\n", error->message);
+
+        page_store_free (store);
+        return;
+    }
+
+    /* written, but the store is gone */
+    if (g_cancellable_is_cancelled (store->cancellable))
+    {
+        page_store_free (store);
+        return;
+    }
+
+    gooroom_notice_pages_account (store->pages, store->name, written);
+    gooroom_notice_pages_evict (store->pages);
+
+    page_store_free (store);
+}
+
+static void
+gooroom_notice_pages_replace_done (GObject *source_object, GAsyncResult *res, gpointer user_data)
+{
+    PageStore *store = (PageStore *)user_data;
+
+    g_autoptr(GError) error = NULL;
+    GFileOutputStream *output = g_file_replace_finish (G_FILE (source_object), res, &error);
+
+    if (!output)
+    {
+        if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+            g_debug ("gooroom_notice_pages_replace_done : %s\n", error->message);
+
+        page_store_free (store);
+        return;
+    }
+
+    /* the copy only replaces the old one once the stream is closed whole */
+    g_output_stream_splice_async (G_OUTPUT_STREAM (output), store->stream,
+                                  G_OUTPUT_STREAM_SPLICE_CLOSE_SOURCE | G_OUTPUT_STREAM_SPLICE_CLOSE_TARGET,
+                                  G_PRIORITY_LOW, store->cancellable,
+                                  gooroom_notice_pages_splice_done, store);
+    g_object_unref (output);
+}
+
+void
+gooroom_notice_pages_store (GooroomNoticePages *pages, const gchar *url, GInputStream *stream)
+{
+    g_return_if_fail (url != NULL);
+    g_return_if_fail (G_IS_INPUT_STREAM (stream));
+
+    if (pages->budget == 0)
+        return;
+
+    PageStore *store;
+    store = g_new0 (PageStore, 1);
+    store->pages = pages;
+    store->cancellable = g_object_ref (pages->cancellable);
+    store->name = gooroom_notice_pages_name (url);
+    store->stream = g_object_ref (stream);
+
+    g_autofree gchar *path = g_build_filename (pages->dir, store->name, NULL);
+    g_autoptr(GFile) file = g_file_new_for_path (path);
+
+    g_file_replace_async (file, NULL, FALSE, G_FILE_CREATE_PRIVATE | G_FILE_CREATE_REPLACE_DESTINATION,
+                          G_PRIORITY_LOW, store->cancellable,
+                          gooroom_notice_pages_replace_done, store);
+}
+
+guint64
+gooroom_notice_pages_size (GooroomNoticePages *pages)
+{
+    return pages->size;
+}
@@ -0,0 +1,50 @@
+/*
+ * Copyright (C) 2018-2019 Gooroom <gooroom@gooroom.kr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#ifndef __GOOROOM_NOTICE_PAGES_H__
+#define __GOOROOM_NOTICE_PAGES_H__
+
+#include <glib.h>
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+/*
+ * Saved copies of notice pages, one self-contained archive per url,
+ * kept under a directory within a byte budget. The least recently used
+ * copy goes first when a new one does not fit; usage survives restarts
+ * through the file modification times. All file work is asynchronous,
+ * so the index is empty until the directory has been scanned.
+ */
+typedef struct _GooroomNoticePages GooroomNoticePages;
+
+GooroomNoticePages *gooroom_notice_pages_new (const gchar *dir, guint64 budget);
+void gooroom_notice_pages_free (GooroomNoticePages *pages);
+
+/* returns the file uri of the copy of @url and marks it used, or NULL */
+gchar *gooroom_notice_pages_lookup (GooroomNoticePages *pages, const gchar *url);
+
+/* replaces the copy of @url with the contents of @stream */
+void gooroom_notice_pages_store (GooroomNoticePages *pages, const gchar *url, GInputStream *stream);
+
+guint64 gooroom_notice_pages_size (GooroomNoticePages *pages);
+
+G_END_DECLS
+
+#endif /* __GOOROOM_NOTICE_PAGES_H__*/
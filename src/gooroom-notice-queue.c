@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2018 - 2019 Gooroom <gooroom@gooroom.kr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <glib.h>
+
+#include "gooroom-notice-queue.h"
+
+struct _NoticeQueue
+{
+    GQueue   classes[GOOROOM_NOTICE_URGENCY_LAST];
+    gint64   delay[GOOROOM_NOTICE_URGENCY_LAST];
+    guint    length;
+};
+
+NoticeQueue *
+gooroom_notice_queue_new (gint64 aging)
+{
+    NoticeQueue *queue;
+    queue = g_new0 (NoticeQueue, 1);
+
+    gint i;
+    for (i = 0; i < GOOROOM_NOTICE_URGENCY_LAST; i++)
+        g_queue_init (&queue->classes[i]);
+
+    queue->delay[GOOROOM_NOTICE_URGENCY_NORMAL] = aging;
+    queue->delay[GOOROOM_NOTICE_URGENCY_CRITICAL] = 0;
+
+    return queue;
+}
+
+void
+gooroom_notice_queue_free (NoticeQueue *queue)
+{
+    if (!queue)
+        return;
+
+    gooroom_notice_queue_clear (queue);
+    g_free (queue);
+}
+
+void
+gooroom_notice_queue_push (NoticeQueue *queue, NoticeData *n, GooroomNoticeUrgency urgency)
+{
+    g_queue_push_tail (&queue->classes[urgency], n);
+    queue->length++;
+}
+
+/* the class whose head has the earliest deadline; ties go to the more urgent class */
+static gint
+gooroom_notice_queue_head_class (NoticeQueue *queue)
+{
+    gint64 best_deadline = 0;
+    gint best = -1;
+    gint i;
+
+    for (i = GOOROOM_NOTICE_URGENCY_LAST - 1; 0 <= i; i--)
+    {
+        NoticeData *n = g_queue_peek_head (&queue->classes[i]);
+        if (!n)
+            continue;
+
+        gint64 deadline = n->received + queue->delay[i];
+        if (best < 0 || deadline < best_deadline)
+        {
+            best = i;
+            best_deadline = deadline;
+        }
+    }
+
+    return best;
+}
+
+NoticeData *
+gooroom_notice_queue_peek (NoticeQueue *queue, GooroomNoticeUrgency *urgency)
+{
+    gint best = gooroom_notice_queue_head_class (queue);
+    if (best < 0)
+        return NULL;
+
+    if (urgency)
+        *urgency = best;
+
+    return g_queue_peek_head (&queue->classes[best]);
+}
+
+NoticeData *
+gooroom_notice_queue_pop (NoticeQueue *queue, GooroomNoticeUrgency *urgency)
+{
+    gint best = gooroom_notice_queue_head_class (queue);
+    if (best < 0)
+        return NULL;
+
+    if (urgency)
+        *urgency = best;
+
+    return gooroom_notice_queue_pop_class (queue, best);
+}
+
+NoticeData *
+gooroom_notice_queue_pop_class (NoticeQueue *queue, GooroomNoticeUrgency urgency)
+{
+    NoticeData *n = g_queue_pop_head (&queue->classes[urgency]);
+
+    if (n)
+        queue->length--;
+
+    return n;
+}
+
+guint
+gooroom_notice_queue_length (NoticeQueue *queue)
+{
+    return queue->length;
+}
+
+guint
+gooroom_notice_queue_class_length (NoticeQueue *queue, GooroomNoticeUrgency urgency)
+{
+    return g_queue_get_length (&queue->classes[urgency]);
+}
+
+void
+gooroom_notice_queue_clear_class (NoticeQueue *queue, GooroomNoticeUrgency urgency)
+{
+    GQueue *q = &queue->classes[urgency];
+
+    queue->length -= g_queue_get_length (q);
+
+    g_queue_foreach (q, (GFunc) gooroom_notice_data_unref, NULL);
+    g_queue_clear (q);
+}
+
+void
+gooroom_notice_queue_clear (NoticeQueue *queue)
+{
+    gint i;
+
+    for (i = 0; i < GOOROOM_NOTICE_URGENCY_LAST; i++)
+        gooroom_notice_queue_clear_class (queue, i);
+}
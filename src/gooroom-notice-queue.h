@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2018-2019 Gooroom <gooroom@gooroom.kr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#ifndef __GOOROOM_NOTICE_QUEUE_H__
+#define __GOOROOM_NOTICE_QUEUE_H__
+
+#include <glib.h>
+
+#include "gooroom-notice-core.h"
+#include "gooroom-notice-data.h"
+
+G_BEGIN_DECLS
+
+/*
+ * Pending notices ordered by urgency with aging. Every notice gets a
+ * virtual deadline of its arrival time plus a per-class delay: none for
+ * critical notices, @aging for normal ones. The notice with the
+ * earliest deadline goes first, so critical notices overtake the
+ * backlog, but a normal notice that has waited @aging is no longer
+ * overtaken by newer critical ones.
+ *
+ * Deadlines within one class never decrease, so each class is a plain
+ * FIFO and only the class heads are compared: push and pop are O(1).
+ */
+typedef struct _NoticeQueue NoticeQueue;
+
+NoticeQueue *gooroom_notice_queue_new (gint64 aging);
+void gooroom_notice_queue_free (NoticeQueue *queue);
+
+/* takes over the caller's reference on @n */
+void gooroom_notice_queue_push (NoticeQueue *queue, NoticeData *n, GooroomNoticeUrgency urgency);
+
+NoticeData *gooroom_notice_queue_peek (NoticeQueue *queue, GooroomNoticeUrgency *urgency);
+NoticeData *gooroom_notice_queue_pop (NoticeQueue *queue, GooroomNoticeUrgency *urgency);
+NoticeData *gooroom_notice_queue_pop_class (NoticeQueue *queue, GooroomNoticeUrgency urgency);
+
+guint gooroom_notice_queue_length (NoticeQueue *queue);
+guint gooroom_notice_queue_class_length (NoticeQueue *queue, GooroomNoticeUrgency urgency);
+
+void gooroom_notice_queue_clear (NoticeQueue *queue);
+void gooroom_notice_queue_clear_class (NoticeQueue *queue, GooroomNoticeUrgency urgency);
+
+G_END_DECLS
+
+#endif /* __GOOROOM_NOTICE_QUEUE_H__*/
@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2018 - 2019 Gooroom <gooroom@gooroom.kr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <unistd.h>
+#ifdef HAVE_MALLOC_TRIM
+#include <malloc.h>
+#endif
+
+#include <glib.h>
+
+#include "gooroom-notice-reclaim.h"
+#include "gooroom-notice-log.h"
+
+struct _GooroomNoticeReclaim
+{
+    guint                     delay;
+    guint                     timeout_id;
+
+    GooroomNoticeStats       *stats;
+    GooroomNoticeReclaimFunc  func;
+    gpointer                  func_data;
+};
+
+guint64
+gooroom_notice_reclaim_rss (void)
+{
+    g_autofree gchar *statm = NULL;
+    unsigned long size = 0, resident = 0;
+
+    if (!g_file_get_contents ("/proc/self/statm", &statm, NULL, NULL))
+        return 0;
+
+    if (sscanf (statm, "%lu %lu", &size, &resident) != 2)
+        return 0;
+
+    return (guint64)resident * sysconf (_SC_PAGESIZE);
+}
+
+static gboolean
+gooroom_notice_reclaim_run (gpointer user_data)
+{
+    GooroomNoticeReclaim *reclaim = (GooroomNoticeReclaim *)user_data;
+
+    reclaim->timeout_id = 0;
+
+    guint64 before = gooroom_notice_reclaim_rss ();
+
+    reclaim->func (reclaim->func_data);
+#ifdef HAVE_MALLOC_TRIM
+    malloc_trim (0);
+#endif
+
+    guint64 after = gooroom_notice_reclaim_rss ();
+
+    g_autofree gchar *rss_before = g_strdup_printf ("%" G_GUINT64_FORMAT, before);
+    g_autofree gchar *rss_after = g_strdup_printf ("%" G_GUINT64_FORMAT, after);
+    gooroom_notice_log_fields (G_LOG_LEVEL_MESSAGE, "memory reclaimed",
+                               "rss_before", rss_before, "rss_after", rss_after, NULL);
+
+    if (reclaim->stats)
+    {
+        gooroom_notice_stats_count (reclaim->stats, GOOROOM_NOTICE_COUNTER_RECLAIMS, 1);
+        if (after < before)
+            gooroom_notice_stats_count (reclaim->stats, GOOROOM_NOTICE_COUNTER_RECLAIMED_BYTES, before - after);
+    }
+
+    return FALSE;
+}
+
+GooroomNoticeReclaim *
+gooroom_notice_reclaim_new (guint delay, GooroomNoticeStats *stats, GooroomNoticeReclaimFunc func, gpointer user_data)
+{
+    g_return_val_if_fail (func != NULL, NULL);
+
+    GooroomNoticeReclaim *reclaim;
+    reclaim = g_new0 (GooroomNoticeReclaim, 1);
+    reclaim->delay = delay;
+    reclaim->stats = stats;
+    reclaim->func = func;
+    reclaim->func_data = user_data;
+
+    return reclaim;
+}
+
+void
+gooroom_notice_reclaim_free (GooroomNoticeReclaim *reclaim)
+{
+    if (!reclaim)
+        return;
+
+    gooroom_notice_reclaim_cancel (reclaim);
+    g_free (reclaim);
+}
+
+void
+gooroom_notice_reclaim_schedule (GooroomNoticeReclaim *reclaim)
+{
+    gooroom_notice_reclaim_cancel (reclaim);
+
+    if (reclaim->delay == 0)
+        return;
+
+    reclaim->timeout_id = g_timeout_add_seconds (reclaim->delay, gooroom_notice_reclaim_run, reclaim);
+}
+
+void
+gooroom_notice_reclaim_cancel (GooroomNoticeReclaim *reclaim)
+{
+    if (reclaim->timeout_id)
+    {
+        g_source_remove (reclaim->timeout_id);
+        reclaim->timeout_id = 0;
+    }
+}
@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2018-2019 Gooroom <gooroom@gooroom.kr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#ifndef __GOOROOM_NOTICE_RECLAIM_H__
+#define __GOOROOM_NOTICE_RECLAIM_H__
+
+#include <glib.h>
+
+#include "gooroom-notice-stats.h"
+
+G_BEGIN_DECLS
+
+/* drops whatever the process can rebuild on demand */
+typedef void (*GooroomNoticeReclaimFunc) (gpointer user_data);
+
+typedef struct _GooroomNoticeReclaim GooroomNoticeReclaim;
+
+/*
+ * Runs @func once @delay seconds have passed since the last
+ * gooroom_notice_reclaim_schedule(), then hands freed heap back to the
+ * kernel and logs the resident size before and after. It runs once per
+ * quiet period; a @delay of 0 disables it. @stats may be NULL.
+ */
+GooroomNoticeReclaim *gooroom_notice_reclaim_new (guint delay,
+                                                  GooroomNoticeStats *stats,
+                                                  GooroomNoticeReclaimFunc func,
+                                                  gpointer user_data);
+void gooroom_notice_reclaim_free (GooroomNoticeReclaim *reclaim);
+
+/* (re)starts the countdown */
+void gooroom_notice_reclaim_schedule (GooroomNoticeReclaim *reclaim);
+
+/* stops the countdown while the process is busy */
+void gooroom_notice_reclaim_cancel (GooroomNoticeReclaim *reclaim);
+
+/* resident set size of the calling process in bytes, 0 if unknown */
+guint64 gooroom_notice_reclaim_rss (void);
+
+G_END_DECLS
+
+#endif /* __GOOROOM_NOTICE_RECLAIM_H__*/
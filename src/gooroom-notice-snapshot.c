@@ -0,0 +1,210 @@
+/*
+ * Copyright (c) 2018 - 2019 Gooroom <gooroom@gooroom.kr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <gio/gio.h>
+
+#include "gooroom-notice-snapshot.h"
+
+typedef struct
+{
+    gchar  *path;
+    GBytes *data;
+}SnapshotWrite;
+
+/* keeps a late worker from renaming over a newer synchronous write */
+static GMutex snapshot_lock;
+
+GVariant *
+gooroom_notice_snapshot_read (const gchar *path)
+{
+    g_return_val_if_fail (path != NULL, NULL);
+
+    GMappedFile *file = g_mapped_file_new (path, FALSE, NULL);
+    if (!file)
+        return NULL;
+
+    GBytes *bytes = g_mapped_file_get_bytes (file);
+    g_mapped_file_unref (file);
+
+    GVariant *snapshot = g_variant_new_from_bytes (G_VARIANT_TYPE (NOTICE_SNAPSHOT_TYPE), bytes, FALSE);
+    g_bytes_unref (bytes);
+    g_variant_ref_sink (snapshot);
+
+    guint32 version = 0;
+    g_variant_get_child (snapshot, 0, "u", &version);
+    if (version != NOTICE_SNAPSHOT_VERSION)
+    {
+        g_variant_unref (snapshot);
+        return NULL;
+    }
+
+    return snapshot;
+}
+
+static void
+snapshot_write_free (gpointer data)
+{
+    SnapshotWrite *w = (SnapshotWrite *)data;
+
+    g_free (w->path);
+    g_bytes_unref (w->data);
+    g_free (w);
+}
+
+static gboolean
+snapshot_write_locked (SnapshotWrite *w, GError **error)
+{
+    g_autofree gchar *dir = g_path_get_dirname (w->path);
+    g_autofree gchar *tmp = g_strdup_printf ("%s.XXXXXX", w->path);
+    gint fd = -1;
+    gint saved_errno;
+    gboolean created = FALSE;
+    gsize len = 0;
+    const gchar *buf = g_bytes_get_data (w->data, &len);
+
+    if (g_mkdir_with_parents (dir, 0700) != 0)
+        goto fail;
+
+    fd = g_mkstemp_full (tmp, O_WRONLY, 0600);
+    if (fd < 0)
+        goto fail;
+    created = TRUE;
+
+    while (0 < len)
+    {
+        gssize n = write (fd, buf, len);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            goto fail;
+        }
+        buf += n;
+        len -= n;
+    }
+
+    if (fsync (fd) != 0)
+        goto fail;
+
+    if (close (fd) != 0)
+    {
+        fd = -1;
+        goto fail;
+    }
+    fd = -1;
+
+    if (g_rename (tmp, w->path) != 0)
+        goto fail;
+
+    return TRUE;
+
+fail:
+    saved_errno = errno;
+
+    if (0 <= fd)
+        close (fd);
+
+    if (created)
+        g_unlink (tmp);
+
+    g_set_error (error, G_IO_ERROR, g_io_error_from_errno (saved_errno),
+                 "%s: %s", w->path, g_strerror (saved_errno));
+    return FALSE;
+}
+
+static void
+snapshot_write_thread (GTask *task, gpointer source, gpointer task_data, GCancellable *cancellable)
+{
+    GError *error = NULL;
+    gboolean ret = FALSE;
+
+    g_mutex_lock (&snapshot_lock);
+    if (!g_cancellable_set_error_if_cancelled (cancellable, &error))
+        ret = snapshot_write_locked ((SnapshotWrite *)task_data, &error);
+    g_mutex_unlock (&snapshot_lock);
+
+    if (ret)
+        g_task_return_boolean (task, TRUE);
+    else
+        g_task_return_error (task, error);
+}
+
+void
+gooroom_notice_snapshot_write_async (const gchar *path,
+                                     GVariant *snapshot,
+                                     GCancellable *cancellable,
+                                     GAsyncReadyCallback callback,
+                                     gpointer user_data)
+{
+    g_return_if_fail (path != NULL);
+    g_return_if_fail (snapshot != NULL);
+
+    SnapshotWrite *w;
+    w = g_new0 (SnapshotWrite, 1);
+    w->path = g_strdup (path);
+
+    g_variant_ref_sink (snapshot);
+    w->data = g_variant_get_data_as_bytes (snapshot);
+    g_variant_unref (snapshot);
+
+    GTask *task = g_task_new (NULL, cancellable, callback, user_data);
+    g_task_set_priority (task, G_PRIORITY_LOW);
+    g_task_set_task_data (task, w, snapshot_write_free);
+    g_task_run_in_thread (task, snapshot_write_thread);
+    g_object_unref (task);
+}
+
+gboolean
+gooroom_notice_snapshot_write_finish (GAsyncResult *result, GError **error)
+{
+    return g_task_propagate_boolean (G_TASK (result), error);
+}
+
+gboolean
+gooroom_notice_snapshot_write (const gchar *path, GVariant *snapshot, GError **error)
+{
+    g_return_val_if_fail (path != NULL, FALSE);
+    g_return_val_if_fail (snapshot != NULL, FALSE);
+
+    SnapshotWrite w;
+    gboolean ret;
+
+    g_variant_ref_sink (snapshot);
+    w.path = (gchar *)path;
+    w.data = g_variant_get_data_as_bytes (snapshot);
+    g_variant_unref (snapshot);
+
+    g_mutex_lock (&snapshot_lock);
+    ret = snapshot_write_locked (&w, error);
+    g_mutex_unlock (&snapshot_lock);
+
+    g_bytes_unref (w.data);
+
+    return ret;
+}
@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2018-2019 Gooroom <gooroom@gooroom.kr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#ifndef __GOOROOM_NOTICE_SNAPSHOT_H__
+#define __GOOROOM_NOTICE_SNAPSHOT_H__
+
+#include <glib.h>
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+#define NOTICE_SNAPSHOT_VERSION  (1)
+
+/*
+ * (version, session metadata, disabled count,
+ *  unread notices as (key, title, url, urgent), seen keys oldest first)
+ */
+#define NOTICE_SNAPSHOT_TYPE     "(ua{ss}ia(sssb)as)"
+
+/* maps @path and returns the snapshot, or NULL if missing or of another version */
+GVariant *gooroom_notice_snapshot_read (const gchar *path);
+
+/*
+ * atomically replaces @path with @snapshot from a worker thread; a write
+ * that has not started when @cancellable is cancelled is skipped
+ */
+void gooroom_notice_snapshot_write_async (const gchar *path,
+                                          GVariant *snapshot,
+                                          GCancellable *cancellable,
+                                          GAsyncReadyCallback callback,
+                                          gpointer user_data);
+gboolean gooroom_notice_snapshot_write_finish (GAsyncResult *result, GError **error);
+
+/* the same on the calling thread, ordered after any write in flight */
+gboolean gooroom_notice_snapshot_write (const gchar *path, GVariant *snapshot, GError **error);
+
+G_END_DECLS
+
+#endif /* __GOOROOM_NOTICE_SNAPSHOT_H__*/
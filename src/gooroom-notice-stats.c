@@ -0,0 +1,204 @@
+/*
+ * Copyright (c) 2018 - 2019 Gooroom <gooroom@gooroom.kr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <glib.h>
+#include <gio/gio.h>
+
+#include "gooroom-notice-stats.h"
+
+#define NOTICE_STATS_FIRST_BOUND (64)
+#define NOTICE_STATS_BUCKETS     (22)
+
+typedef struct
+{
+    guint64  count;
+    guint64  sum;
+    guint64  buckets[NOTICE_STATS_BUCKETS];
+}NoticeHistogram;
+
+struct _GooroomNoticeStats
+{
+    guint64          counters[GOOROOM_NOTICE_COUNTER_LAST];
+    NoticeHistogram  histograms[GOOROOM_NOTICE_HISTOGRAM_LAST];
+
+    GooroomNoticeStatsGauges  gauges;
+    gpointer                  gauges_data;
+};
+
+static const gchar *counter_names[GOOROOM_NOTICE_COUNTER_LAST] =
+{
+    "payloads",
+    "payload_errors",
+    "notices_received",
+    "notices_dropped",
+    "notices_shown",
+    "notices_collapsed",
+    "digests",
+    "agent_calls",
+    "agent_errors",
+    "viewer_opens",
+    "page_loads",
+    "page_load_errors",
+    "prefetches",
+    "prefetch_hits",
+    "reclaims",
+    "reclaimed_bytes"
+};
+
+static const gchar *histogram_names[GOOROOM_NOTICE_HISTOGRAM_LAST] =
+{
+    "parse_us",
+    "agent_rtt_us",
+    "display_latency_us",
+    "page_load_us"
+};
+
+static const gchar introspection_xml[] =
+    "<node>"
+    "  <interface name='" GOOROOM_NOTICE_STATS_INTERFACE "'>"
+    "    <method name='GetStats'>"
+    "      <arg type='a{sv}' name='stats' direction='out'/>"
+    "    </method>"
+    "  </interface>"
+    "</node>";
+
+GooroomNoticeStats *
+gooroom_notice_stats_new (GooroomNoticeStatsGauges gauges, gpointer user_data)
+{
+    GooroomNoticeStats *stats;
+    stats = g_new0 (GooroomNoticeStats, 1);
+
+    stats->gauges = gauges;
+    stats->gauges_data = user_data;
+
+    return stats;
+}
+
+void
+gooroom_notice_stats_free (GooroomNoticeStats *stats)
+{
+    g_free (stats);
+}
+
+void
+gooroom_notice_stats_count (GooroomNoticeStats *stats, GooroomNoticeCounter counter, guint64 n)
+{
+    stats->counters[counter] += n;
+}
+
+void
+gooroom_notice_stats_observe (GooroomNoticeStats *stats, GooroomNoticeHistogram histogram, gint64 usec)
+{
+    NoticeHistogram *h = &stats->histograms[histogram];
+    guint64 value = MAX (usec, 0);
+    guint bucket = 0;
+
+    if (NOTICE_STATS_FIRST_BOUND < value)
+        bucket = MIN (g_bit_storage (value - 1) - 6, NOTICE_STATS_BUCKETS - 1);
+
+    h->count++;
+    h->sum += value;
+    h->buckets[bucket]++;
+}
+
+GVariant *
+gooroom_notice_stats_snapshot (GooroomNoticeStats *stats)
+{
+    GVariantBuilder builder;
+    guint i;
+
+    g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{sv}"));
+
+    for (i = 0; i < GOOROOM_NOTICE_COUNTER_LAST; i++)
+        g_variant_builder_add (&builder, "{sv}", counter_names[i], g_variant_new_uint64 (stats->counters[i]));
+
+    if (stats->gauges)
+        stats->gauges (&builder, stats->gauges_data);
+
+    for (i = 0; i < GOOROOM_NOTICE_HISTOGRAM_LAST; i++)
+    {
+        NoticeHistogram *h = &stats->histograms[i];
+        GVariant *buckets = g_variant_new_fixed_array (G_VARIANT_TYPE_UINT64, h->buckets, NOTICE_STATS_BUCKETS, sizeof (guint64));
+
+        g_variant_builder_add (&builder, "{sv}", histogram_names[i],
+                g_variant_new ("(tt@at)", h->count, h->sum, buckets));
+    }
+
+    guint64 bounds[NOTICE_STATS_BUCKETS];
+    for (i = 0; i < NOTICE_STATS_BUCKETS - 1; i++)
+        bounds[i] = (guint64)NOTICE_STATS_FIRST_BOUND << i;
+    bounds[i] = G_MAXUINT64;
+
+    g_variant_builder_add (&builder, "{sv}", "histogram_bounds_us",
+            g_variant_new_fixed_array (G_VARIANT_TYPE_UINT64, bounds, NOTICE_STATS_BUCKETS, sizeof (guint64)));
+
+    return g_variant_builder_end (&builder);
+}
+
+static void
+gooroom_notice_stats_method_call (GDBusConnection *connection,
+                                  const gchar *sender,
+                                  const gchar *object_path,
+                                  const gchar *interface_name,
+                                  const gchar *method_name,
+                                  GVariant *parameters,
+                                  GDBusMethodInvocation *invocation,
+                                  gpointer user_data)
+{
+    GooroomNoticeStats *stats = (GooroomNoticeStats *)user_data;
+
+    if (g_strcmp0 (method_name, "GetStats") == 0)
+    {
+        GVariant *snapshot = gooroom_notice_stats_snapshot (stats);
+        g_dbus_method_invocation_return_value (invocation, g_variant_new_tuple (&snapshot, 1));
+        return;
+    }
+
+    g_dbus_method_invocation_return_error (invocation, G_DBUS_ERROR, G_DBUS_ERROR_UNKNOWN_METHOD,
+            "Unknown method %s", method_name);
+}
+
+static const GDBusInterfaceVTable stats_vtable =
+{
+    gooroom_notice_stats_method_call,
+    NULL,
+    NULL
+};
+
+guint
+gooroom_notice_stats_export (GooroomNoticeStats *stats,
+                             GDBusConnection *connection,
+                             const gchar *object_path,
+                             GError **error)
+{
+    GDBusNodeInfo *node = g_dbus_node_info_new_for_xml (introspection_xml, error);
+    if (!node)
+        return 0;
+
+    guint id = g_dbus_connection_register_object (connection, object_path,
+            node->interfaces[0], &stats_vtable, stats, NULL, error);
+
+    g_dbus_node_info_unref (node);
+
+    return id;
+}
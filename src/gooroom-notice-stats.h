@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2018-2019 Gooroom <gooroom@gooroom.kr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#ifndef __GOOROOM_NOTICE_STATS_H__
+#define __GOOROOM_NOTICE_STATS_H__
+
+#include <glib.h>
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+#define GOOROOM_NOTICE_STATS_INTERFACE "kr.gooroom.noticeapplet.Stats"
+
+typedef enum
+{
+    GOOROOM_NOTICE_COUNTER_PAYLOADS,
+    GOOROOM_NOTICE_COUNTER_PAYLOAD_ERRORS,
+    GOOROOM_NOTICE_COUNTER_NOTICES_RECEIVED,
+    GOOROOM_NOTICE_COUNTER_NOTICES_DROPPED,
+    GOOROOM_NOTICE_COUNTER_NOTICES_SHOWN,
+    GOOROOM_NOTICE_COUNTER_NOTICES_COLLAPSED,
+    GOOROOM_NOTICE_COUNTER_DIGESTS,
+    GOOROOM_NOTICE_COUNTER_AGENT_CALLS,
+    GOOROOM_NOTICE_COUNTER_AGENT_ERRORS,
+    GOOROOM_NOTICE_COUNTER_VIEWER_OPENS,
+    GOOROOM_NOTICE_COUNTER_PAGE_LOADS,
+    GOOROOM_NOTICE_COUNTER_PAGE_LOAD_ERRORS,
+    GOOROOM_NOTICE_COUNTER_PREFETCHES,
+    GOOROOM_NOTICE_COUNTER_PREFETCH_HITS,
+    GOOROOM_NOTICE_COUNTER_RECLAIMS,
+    GOOROOM_NOTICE_COUNTER_RECLAIMED_BYTES,
+    GOOROOM_NOTICE_COUNTER_LAST
+} GooroomNoticeCounter;
+
+typedef enum
+{
+    GOOROOM_NOTICE_HISTOGRAM_PARSE,
+    GOOROOM_NOTICE_HISTOGRAM_AGENT_RTT,
+    GOOROOM_NOTICE_HISTOGRAM_DISPLAY_LATENCY,
+    GOOROOM_NOTICE_HISTOGRAM_PAGE_LOAD,
+    GOOROOM_NOTICE_HISTOGRAM_LAST
+} GooroomNoticeHistogram;
+
+/* fills the live values (queue depth and the like) into an a{sv} builder */
+typedef void (*GooroomNoticeStatsGauges) (GVariantBuilder *builder, gpointer user_data);
+
+typedef struct _GooroomNoticeStats GooroomNoticeStats;
+
+GooroomNoticeStats *gooroom_notice_stats_new (GooroomNoticeStatsGauges gauges, gpointer user_data);
+void gooroom_notice_stats_free (GooroomNoticeStats *stats);
+
+void gooroom_notice_stats_count (GooroomNoticeStats *stats, GooroomNoticeCounter counter, guint64 n);
+
+/*
+ * Records a duration in microseconds. Histograms use power-of-two
+ * buckets from 64 us up to about 67 s plus an overflow bucket, so
+ * recording is a couple of integer operations.
+ */
+void gooroom_notice_stats_observe (GooroomNoticeStats *stats, GooroomNoticeHistogram histogram, gint64 usec);
+
+/*
+ * Returns an a{sv}: counters as "t", gauges as "u", histograms as
+ * "(ttat)" (count, sum in us, bucket counts) and the bucket upper
+ * bounds in us under "histogram_bounds_us".
+ */
+GVariant *gooroom_notice_stats_snapshot (GooroomNoticeStats *stats);
+
+/* exports GOOROOM_NOTICE_STATS_INTERFACE at @object_path; returns the registration id or 0 */
+guint gooroom_notice_stats_export (GooroomNoticeStats *stats,
+                                   GDBusConnection *connection,
+                                   const gchar *object_path,
+                                   GError **error);
+
+G_END_DECLS
+
+#endif /* __GOOROOM_NOTICE_STATS_H__*/
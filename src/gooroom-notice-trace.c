@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2018 - 2019 Gooroom <gooroom@gooroom.kr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef HAVE_SYS_SDT_H
+#include <sys/sdt.h>
+#endif
+
+#include <glib.h>
+
+#include "gooroom-notice-trace.h"
+
+static gboolean     trace_ready = FALSE;
+static FILE        *trace_file = NULL;
+static GHashTable  *trace_seen = NULL;
+static gint64       trace_origin = 0;
+
+static gint64
+trace_now (void)
+{
+    struct timespec ts;
+
+    /* the clock /proc/<pid>/stat counts process start times in */
+    if (clock_gettime (CLOCK_BOOTTIME, &ts) != 0)
+        return g_get_monotonic_time ();
+
+    return (gint64)ts.tv_sec * G_USEC_PER_SEC + ts.tv_nsec / 1000;
+}
+
+/* field 22 of /proc/self/stat, in clock ticks since boot */
+static gint64
+trace_process_start (void)
+{
+    g_autofree gchar *stat = NULL;
+    long hz = sysconf (_SC_CLK_TCK);
+
+    if (hz <= 0 || !g_file_get_contents ("/proc/self/stat", &stat, NULL, NULL))
+        return 0;
+
+    /* the command name may contain spaces, the fields after it do not */
+    gchar *p = strrchr (stat, ')');
+    if (!p)
+        return 0;
+
+    g_auto(GStrv) fields = g_strsplit (p + 2, " ", 21);
+    if (g_strv_length (fields) < 20)
+        return 0;
+
+    return g_ascii_strtoll (fields[19], NULL, 10) * G_USEC_PER_SEC / hz;
+}
+
+static void
+trace_init (void)
+{
+    trace_ready = TRUE;
+
+    const gchar *path = g_getenv (GOOROOM_NOTICE_TRACE_ENV);
+    if (!path || !*path)
+        return;
+
+    /* appended, so that processes started by the applet can share the file */
+    trace_file = fopen (path, "a");
+    if (!trace_file)
+    {
+        g_warning ("trace_init : %s: %s\n", path, g_strerror (errno));
+        return;
+    }
+
+    trace_seen = g_hash_table_new (g_str_hash, g_str_equal);
+
+    trace_origin = trace_process_start ();
+    if (!trace_origin || trace_now () < trace_origin)
+        trace_origin = trace_now ();
+}
+
+void
+gooroom_notice_trace_mark (const gchar *name)
+{
+#ifdef HAVE_SYS_SDT_H
+    DTRACE_PROBE1 (gooroom_notice, mark, name);
+#endif
+
+    if (!trace_ready)
+        trace_init ();
+
+    if (!trace_file || g_hash_table_contains (trace_seen, name))
+        return;
+
+    g_hash_table_add (trace_seen, (gpointer)name);
+
+    gint64 elapsed = trace_now () - trace_origin;
+
+    fprintf (trace_file, "%d %" G_GINT64_FORMAT " %s\n", (int)getpid (), elapsed, name);
+    fflush (trace_file);
+
+    g_debug ("gooroom_notice_trace_mark : %s +%" G_GINT64_FORMAT "us\n", name, elapsed);
+}
@@ -0,0 +1,40 @@
+/*
+ * Copyright (C) 2018-2019 Gooroom <gooroom@gooroom.kr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#ifndef __GOOROOM_NOTICE_TRACE_H__
+#define __GOOROOM_NOTICE_TRACE_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+#define GOOROOM_NOTICE_TRACE_ENV "GOOROOM_NOTICE_TRACE"
+
+/*
+ * Startup timeline. When GOOROOM_NOTICE_TRACE names a file, the first
+ * occurrence of every mark is appended to it as "pid usec name", the
+ * time counted from the exec of the process. Every call also fires the
+ * gooroom_notice:mark USDT probe when the build has <sys/sdt.h>.
+ * @name must be a static string.
+ */
+void gooroom_notice_trace_mark (const gchar *name);
+
+G_END_DECLS
+
+#endif /* __GOOROOM_NOTICE_TRACE_H__*/
@@ -0,0 +1,1109 @@
+/*
+ * Copyright (c) 2018 - 2019 Gooroom <gooroom@gooroom.kr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <sys/stat.h>
+
+#include <glib.h>
+#include <glib/gi18n.h>
+#include <glib/gstdio.h>
+#include <gtk/gtk.h>
+
+#include <webkit2/webkit2.h>
+
+#include "gooroom-notice-viewer.h"
+#include "gooroom-notice-core.h"
+#include "gooroom-notice-log.h"
+#include "gooroom-notice-pages.h"
+#include "gooroom-notice-reclaim.h"
+
+#define NOTICE_POPUP_POOL_SIZE   (2)
+#define NOTICE_LOG_FILE          "/var/tmp/notice-viewer.debug"
+#define NOTICE_LOG_FILE_SIZE     (1024)
+#define NOTICE_LOG_FILES         (3)
+
+typedef struct
+{
+    GtkWidget     *window;
+    WebKitWebView *view;
+    gint64         load_start;
+    gchar         *url;
+
+    /* the offline copy on screen until the live page replaces it */
+    gchar         *saved;
+    gboolean       saved_shown;
+    gboolean       live_ready;
+
+    /* set while the popup holds a prefetched page nobody asked for yet */
+    gchar         *prefetch_url;
+    guint64        prefetch_bytes;
+    gboolean       prefetch_started;
+    gboolean       prefetch_loading;
+    gboolean       prefetch_cut;
+}NoticePopup;
+
+typedef struct
+{
+    gchar    *url;
+    gchar    *client_id;
+    gchar    *session_id;
+    gchar    *signing;
+}NoticePrefetch;
+
+/* the notice popups, their web context and the pages kept for them */
+typedef struct
+{
+    GooroomNoticeStats *stats;
+
+    NoticePopup  *popup;
+    GQueue       *popup_pool;
+    guint         popup_serial;
+
+    GQueue       *prefetched;
+    GQueue       *prefetch_pending;
+    guint         prefetch_id;
+    guint         prefetch_limit;
+    guint64       prefetch_bytes;
+    guint64       prefetch_budget;
+
+    GooroomNoticePages *pages;
+    guint64             disk_cache_size;
+
+    WebKitWebContext *web_context;
+
+    guint         owner_id;
+    guint         idle_timeout;
+    guint         idle_id;
+
+    GooroomNoticeReclaim *reclaim;
+}GooroomNoticeViewer;
+
+typedef struct
+{
+    GooroomNoticeViewer *viewer;
+    gchar    *url;
+    guint     serial;
+    gint      pending;
+    gboolean  prefetch;
+}CookieBatch;
+
+static gint idle_timeout = NOTICE_VIEWER_IDLE_TIMEOUT;
+static gint disk_cache = NOTICE_VIEWER_DISK_CACHE_SIZE;
+static gint prefetch_concurrency = NOTICE_VIEWER_PREFETCH_CONCURRENCY;
+static gint prefetch_budget = NOTICE_VIEWER_PREFETCH_BUDGET;
+static gint offline_cache = NOTICE_VIEWER_OFFLINE_CACHE_SIZE;
+static gint reclaim_delay = NOTICE_VIEWER_RECLAIM_DELAY;
+static gint log_level = 4;
+
+static GOptionEntry entries[] =
+{
+    { "idle-timeout", 0, 0, G_OPTION_ARG_INT, &idle_timeout, "Seconds to stay around with nothing on screen", "S" },
+    { "disk-cache", 0, 0, G_OPTION_ARG_INT, &disk_cache, "Web disk cache limit", "MB" },
+    { "prefetch-concurrency", 0, 0, G_OPTION_ARG_INT, &prefetch_concurrency, "Pages prefetched at once (0: off)", "N" },
+    { "prefetch-budget", 0, 0, G_OPTION_ARG_INT, &prefetch_budget, "Bytes received by prefetched pages", "KB" },
+    { "offline-cache", 0, 0, G_OPTION_ARG_INT, &offline_cache, "Saved notice pages (0: off)", "MB" },
+    { "reclaim-delay", 0, 0, G_OPTION_ARG_INT, &reclaim_delay, "Seconds idle before dropping web processes and caches (0: never)", "S" },
+    { "log-level", 0, 0, G_OPTION_ARG_INT, &log_level, "Syslog level logged to " NOTICE_LOG_FILE, "LEVEL" },
+    { NULL }
+};
+
+static void gooroom_notice_prefetch_schedule (GooroomNoticeViewer *viewer);
+
+static gboolean
+on_notice_viewer_idle (gpointer user_data)
+{
+    GooroomNoticeViewer *viewer = (GooroomNoticeViewer *)user_data;
+
+    viewer->idle_id = 0;
+    g_debug ("on_notice_viewer_idle : exiting after %u seconds\n", viewer->idle_timeout);
+
+    /* calls from here on fail fast and make the applet start a new viewer */
+    g_bus_unown_name (viewer->owner_id);
+    viewer->owner_id = 0;
+
+    gtk_main_quit ();
+
+    return FALSE;
+}
+
+/* (re)starts the reclaim and idle countdowns once nothing is on screen or loading */
+static void
+gooroom_notice_viewer_touch (GooroomNoticeViewer *viewer)
+{
+    GList *l;
+
+    if (viewer->idle_id)
+    {
+        g_source_remove (viewer->idle_id);
+        viewer->idle_id = 0;
+    }
+    gooroom_notice_reclaim_cancel (viewer->reclaim);
+
+    if (viewer->popup || !g_queue_is_empty (viewer->prefetch_pending))
+        return;
+
+    for (l = viewer->prefetched->head; l; l = l->next)
+    {
+        if (((NoticePopup *)l->data)->prefetch_loading)
+            return;
+    }
+
+    gooroom_notice_reclaim_schedule (viewer->reclaim);
+    viewer->idle_id = g_timeout_add_seconds (viewer->idle_timeout, on_notice_viewer_idle, viewer);
+}
+
+static void
+gooroom_notice_add_cookie (WebKitCookieManager *manager,
+                           gchar *key,
+                           gchar *value,
+                           gchar *domain,
+                           GAsyncReadyCallback callback,
+                           gpointer user_data)
+{
+    SoupCookie *cookie = soup_cookie_new (key, value, domain, "/", -1);
+    webkit_cookie_manager_add_cookie (manager, cookie, NULL, callback, user_data);
+    soup_cookie_free (cookie);
+}
+
+static void
+gooroom_notice_popup_load (GooroomNoticeViewer *viewer, const gchar *url)
+{
+    if (viewer->popup == NULL)
+        return;
+
+    webkit_web_view_load_uri (viewer->popup->view, url);
+}
+
+static NoticePopup*
+gooroom_notice_prefetch_find (GooroomNoticeViewer *viewer, const gchar *url)
+{
+    GList *l;
+
+    for (l = viewer->prefetched->head; l; l = l->next)
+    {
+        NoticePopup *popup = l->data;
+        if (g_strcmp0 (popup->prefetch_url, url) == 0)
+            return popup;
+    }
+    return NULL;
+}
+
+/* the popup stops being a prefetch and gives its bytes back to the budget */
+static void
+gooroom_notice_prefetch_forget (GooroomNoticeViewer *viewer, NoticePopup *popup)
+{
+    if (!popup->prefetch_url)
+        return;
+
+    g_queue_remove (viewer->prefetched, popup);
+    viewer->prefetch_bytes -= popup->prefetch_bytes;
+
+    g_clear_pointer (&popup->prefetch_url, g_free);
+    popup->prefetch_bytes = 0;
+    popup->prefetch_started = FALSE;
+    popup->prefetch_loading = FALSE;
+    popup->prefetch_cut = FALSE;
+}
+
+/* the live page loads over the saved copy once the copy is up and the cookies are in */
+static void
+gooroom_notice_popup_revalidate (NoticePopup *popup)
+{
+    if (!popup->saved_shown || !popup->live_ready)
+        return;
+
+    popup->live_ready = FALSE;
+    webkit_web_view_load_uri (popup->view, popup->url);
+}
+
+static void
+gooroom_notice_popup_cookies_ready (GooroomNoticeViewer *viewer, const gchar *url, guint serial, gboolean prefetch)
+{
+    if (prefetch)
+    {
+        NoticePopup *popup = gooroom_notice_prefetch_find (viewer, url);
+        if (popup && popup->prefetch_loading && !popup->prefetch_started)
+        {
+            popup->prefetch_started = TRUE;
+            webkit_web_view_load_uri (popup->view, url);
+        }
+        return;
+    }
+
+    if (serial != viewer->popup_serial || viewer->popup == NULL)
+        return;
+
+    if (viewer->popup->saved)
+    {
+        viewer->popup->live_ready = TRUE;
+        gooroom_notice_popup_revalidate (viewer->popup);
+        return;
+    }
+
+    gooroom_notice_popup_load (viewer, url);
+}
+
+static void
+on_notification_popup_cookie_cb (GObject *source_object, GAsyncResult *res, gpointer user_data)
+{
+    CookieBatch *batch = (CookieBatch *)user_data;
+
+    GError *error = NULL;
+    if (!webkit_cookie_manager_add_cookie_finish (WEBKIT_COOKIE_MANAGER (source_object), res, &error))
+    {
+        g_debug ("on_notification_popup_cookie_cb : %s\n", error->message);
+        g_error_free (error);
+    }
+
+    if (--batch->pending != 0)
+        return;
+
+    gooroom_notice_popup_cookies_ready (batch->viewer, batch->url, batch->serial, batch->prefetch);
+
+    g_free (batch->url);
+    g_free (batch);
+}
+
+static gchar*
+gooroom_notice_get_language ()
+{
+    gchar *lang = NULL;
+
+    PangoLanguage *language = gtk_get_default_language();
+
+    if (language)
+    {
+        const gchar *plang = pango_language_to_string (language);
+
+        if (g_strcmp0 (plang, "ko-kr") == 0)
+            lang = g_strdup ("ko");
+        else
+            lang = g_strdup ("en");
+    }
+
+    return lang;
+}
+
+static void
+gooroom_notice_popup_recycle (GooroomNoticeViewer *viewer, NoticePopup *popup)
+{
+    gooroom_notice_prefetch_forget (viewer, popup);
+    g_clear_pointer (&popup->url, g_free);
+    g_clear_pointer (&popup->saved, g_free);
+    popup->saved_shown = FALSE;
+    popup->live_ready = FALSE;
+
+    if (NOTICE_POPUP_POOL_SIZE <= g_queue_get_length (viewer->popup_pool))
+    {
+        gtk_widget_destroy (popup->window);
+        g_free (popup);
+        return;
+    }
+
+    gtk_widget_hide (popup->window);
+    webkit_web_view_stop_loading (popup->view);
+    webkit_web_view_load_uri (popup->view, "about:blank");
+    gtk_window_set_default_size (GTK_WINDOW (popup->window), 600, 550);
+
+    g_queue_push_tail (viewer->popup_pool, popup);
+}
+
+static void
+gooroom_notice_popup_release (GooroomNoticeViewer *viewer)
+{
+    NoticePopup *popup = viewer->popup;
+    if (popup == NULL)
+        return;
+
+    viewer->popup = NULL;
+    viewer->popup_serial++;
+
+    gooroom_notice_popup_recycle (viewer, popup);
+    gooroom_notice_viewer_touch (viewer);
+}
+
+static gboolean
+on_notification_popup_closed (GtkWidget *widget, gpointer user_data)
+{
+    g_return_val_if_fail (user_data != NULL, TRUE);
+
+    gooroom_notice_popup_release ((GooroomNoticeViewer *)user_data);
+
+    return TRUE;
+}
+
+static gboolean
+on_notification_popup_delete_cb (GtkWidget *widget, GdkEvent *event, gpointer user_data)
+{
+    return on_notification_popup_closed (widget, user_data);
+}
+
+static gboolean
+on_notification_popup_webview_closed (WebKitWebView* web_view, gpointer user_data)
+{
+    return on_notification_popup_closed (GTK_WIDGET (web_view), user_data);
+}
+
+static void
+on_notification_popup_saved (GObject *source_object, GAsyncResult *res, gpointer user_data)
+{
+    GooroomNoticeViewer *viewer = g_object_get_data (source_object, "notice-viewer");
+    g_autofree gchar *url = (gchar *)user_data;
+
+    g_autoptr(GError) error = NULL;
+    g_autoptr(GInputStream) stream = webkit_web_view_save_finish (WEBKIT_WEB_VIEW (source_object), res, &error);
+    if (!stream)
+    {
+        g_debug ("on_notification_popup_saved : %s\n", error->message);
+        return;
+    }
+
+    gooroom_notice_pages_store (viewer->pages, url, stream);
+}
+
+/* keeps a copy of a fully loaded notice page for reading offline */
+static void
+gooroom_notice_popup_save (NoticePopup *popup)
+{
+    const gchar *url = popup->prefetch_url ? popup->prefetch_url : popup->url;
+
+    if (!url || popup->prefetch_cut)
+        return;
+
+    /* the saved copy itself */
+    const gchar *current = webkit_web_view_get_uri (popup->view);
+    if (!current || g_str_has_prefix (current, "file:"))
+        return;
+
+    webkit_web_view_save (popup->view, WEBKIT_SAVE_MODE_MHTML, NULL, on_notification_popup_saved, g_strdup (url));
+}
+
+static void
+on_notification_popup_load_changed (WebKitWebView *web_view, WebKitLoadEvent load_event, gpointer user_data)
+{
+    GooroomNoticeViewer *viewer = (GooroomNoticeViewer *)user_data;
+    NoticePopup *popup = g_object_get_data (G_OBJECT (web_view), "notice-popup");
+
+    /* the blank page that parks a pooled popup is not a notice */
+    if (!popup || g_strcmp0 (webkit_web_view_get_uri (web_view), "about:blank") == 0)
+        return;
+
+    /* nobody is waiting for a prefetch; a finished one frees a slot */
+    if (popup->prefetch_url)
+    {
+        if (load_event == WEBKIT_LOAD_FINISHED && popup->prefetch_loading)
+        {
+            popup->prefetch_loading = FALSE;
+            gooroom_notice_popup_save (popup);
+            gooroom_notice_prefetch_schedule (viewer);
+            gooroom_notice_viewer_touch (viewer);
+        }
+        return;
+    }
+
+    if (popup->saved)
+    {
+        if (g_strcmp0 (webkit_web_view_get_uri (web_view), popup->saved) == 0)
+        {
+            if (load_event == WEBKIT_LOAD_FINISHED)
+            {
+                popup->saved_shown = TRUE;
+                gooroom_notice_popup_revalidate (popup);
+            }
+            return;
+        }
+
+        /* the live page is on screen; the copy is no longer needed as a fallback */
+        if (load_event == WEBKIT_LOAD_COMMITTED)
+            g_clear_pointer (&popup->saved, g_free);
+    }
+
+    if (load_event == WEBKIT_LOAD_STARTED)
+    {
+        popup->load_start = g_get_monotonic_time ();
+    }
+    else if (load_event == WEBKIT_LOAD_FINISHED && popup->load_start)
+    {
+        GooroomNoticeStats *stats = viewer->stats;
+
+        gooroom_notice_stats_observe (stats, GOOROOM_NOTICE_HISTOGRAM_PAGE_LOAD, g_get_monotonic_time () - popup->load_start);
+        gooroom_notice_stats_count (stats, GOOROOM_NOTICE_COUNTER_PAGE_LOADS, 1);
+        popup->load_start = 0;
+
+        gooroom_notice_popup_save (popup);
+    }
+}
+
+static gboolean
+on_notification_popup_load_failed (WebKitWebView *web_view,
+                                   WebKitLoadEvent load_event,
+                                   gchar *failing_uri,
+                                   GError *error,
+                                   gpointer user_data)
+{
+    GooroomNoticeViewer *viewer = (GooroomNoticeViewer *)user_data;
+    NoticePopup *popup = g_object_get_data (G_OBJECT (web_view), "notice-popup");
+
+    if (popup && popup->prefetch_url)
+    {
+        popup->prefetch_loading = FALSE;
+        popup->prefetch_cut = TRUE;
+        gooroom_notice_prefetch_schedule (viewer);
+        gooroom_notice_viewer_touch (viewer);
+        return FALSE;
+    }
+
+    if (popup)
+        popup->load_start = 0;
+
+    g_debug ("on_notification_popup_load_failed : %s\n", error->message);
+
+    if (popup && popup->saved)
+    {
+        /* a broken copy: the live page loads on its own */
+        if (g_strcmp0 (failing_uri, popup->saved) == 0)
+        {
+            g_clear_pointer (&popup->saved, g_free);
+            popup->saved_shown = TRUE;
+            gooroom_notice_popup_revalidate (popup);
+            return FALSE;
+        }
+
+        gooroom_notice_stats_count (viewer->stats, GOOROOM_NOTICE_COUNTER_PAGE_LOAD_ERRORS, 1);
+
+        if (g_error_matches (error, WEBKIT_NETWORK_ERROR, WEBKIT_NETWORK_ERROR_CANCELLED))
+            return FALSE;
+
+        /* the live page did not come: keep reading the saved copy */
+        webkit_web_view_load_uri (web_view, popup->saved);
+        return TRUE;
+    }
+
+    gooroom_notice_stats_count (viewer->stats, GOOROOM_NOTICE_COUNTER_PAGE_LOAD_ERRORS, 1);
+
+    return FALSE;
+}
+
+/* a prefetch that outgrows the byte budget is cut off and loaded again on demand */
+static void
+on_notification_popup_resource_data (WebKitWebResource *resource, guint64 length, gpointer user_data)
+{
+    WebKitWebView *view = WEBKIT_WEB_VIEW (user_data);
+    NoticePopup *popup = g_object_get_data (G_OBJECT (view), "notice-popup");
+    GooroomNoticeViewer *viewer = g_object_get_data (G_OBJECT (view), "notice-viewer");
+
+    if (!popup || !popup->prefetch_url || popup->prefetch_cut)
+        return;
+
+    popup->prefetch_bytes += length;
+    viewer->prefetch_bytes += length;
+
+    if (viewer->prefetch_bytes <= viewer->prefetch_budget)
+        return;
+
+    g_debug ("on_notification_popup_resource_data : prefetch budget exceeded, stopping %s\n", popup->prefetch_url);
+
+    popup->prefetch_cut = TRUE;
+    webkit_web_view_stop_loading (view);
+}
+
+static void
+on_notification_popup_resource_started (WebKitWebView *web_view,
+                                        WebKitWebResource *resource,
+                                        WebKitURIRequest *request,
+                                        gpointer user_data)
+{
+    NoticePopup *popup = g_object_get_data (G_OBJECT (web_view), "notice-popup");
+
+    if (!popup || !popup->prefetch_url)
+        return;
+
+    g_signal_connect_object (resource, "received-data", G_CALLBACK (on_notification_popup_resource_data), web_view, 0);
+}
+
+static guint64
+gooroom_notice_web_cache_du (const gchar *path)
+{
+    guint64 size = 0;
+    GDir *dir = g_dir_open (path, 0, NULL);
+
+    if (!dir)
+        return 0;
+
+    const gchar *name;
+    while ((name = g_dir_read_name (dir)))
+    {
+        g_autofree gchar *child = g_build_filename (path, name, NULL);
+        GStatBuf st;
+
+        if (g_lstat (child, &st) != 0)
+            continue;
+
+        if (S_ISDIR (st.st_mode))
+            size += gooroom_notice_web_cache_du (child);
+        else
+            size += st.st_size;
+    }
+    g_dir_close (dir);
+
+    return size;
+}
+
+static void
+gooroom_notice_web_cache_measure_thread (GTask *task, gpointer source, gpointer task_data, GCancellable *cancellable)
+{
+    guint64 *size = g_new (guint64, 1);
+    *size = gooroom_notice_web_cache_du ((const gchar *)task_data);
+    g_task_return_pointer (task, size, g_free);
+}
+
+static void
+gooroom_notice_web_cache_measure_done (GObject *source_object, GAsyncResult *res, gpointer user_data)
+{
+    GooroomNoticeViewer *viewer = (GooroomNoticeViewer *)user_data;
+
+    g_autofree guint64 *size = g_task_propagate_pointer (G_TASK (res), NULL);
+    if (!size || !viewer->web_context)
+        return;
+
+    guint64 limit = viewer->disk_cache_size;
+    if (*size <= limit)
+        return;
+
+    g_debug ("gooroom_notice_web_cache_measure_done : disk cache %" G_GUINT64_FORMAT " bytes exceeds limit, clearing\n", *size);
+
+    WebKitWebsiteDataManager *manager = webkit_web_context_get_website_data_manager (viewer->web_context);
+    webkit_website_data_manager_clear (manager, WEBKIT_WEBSITE_DATA_DISK_CACHE, 0, NULL, NULL, NULL);
+}
+
+static WebKitWebContext*
+gooroom_notice_web_context_get (GooroomNoticeViewer *viewer)
+{
+    if (viewer->web_context)
+        return viewer->web_context;
+
+    g_autofree gchar *cache_dir = g_build_filename (g_get_user_cache_dir (), PACKAGE_NAME, NULL);
+    g_autofree gchar *data_dir = g_build_filename (g_get_user_data_dir (), PACKAGE_NAME, NULL);
+
+    WebKitWebsiteDataManager *manager;
+    manager = webkit_website_data_manager_new ("base-cache-directory", cache_dir,
+                                               "base-data-directory", data_dir,
+                                               NULL);
+
+    viewer->web_context = webkit_web_context_new_with_website_data_manager (manager);
+    g_object_unref (manager);
+
+    webkit_web_context_set_cache_model (viewer->web_context, WEBKIT_CACHE_MODEL_DOCUMENT_BROWSER);
+    webkit_web_context_set_process_model (viewer->web_context, WEBKIT_PROCESS_MODEL_SHARED_SECONDARY_PROCESS);
+
+    GTask *task = g_task_new (NULL, NULL, gooroom_notice_web_cache_measure_done, viewer);
+    g_task_set_priority (task, G_PRIORITY_LOW);
+    g_task_set_task_data (task, g_strdup (webkit_website_data_manager_get_disk_cache_directory (manager)), g_free);
+    g_task_run_in_thread (task, gooroom_notice_web_cache_measure_thread);
+    g_object_unref (task);
+
+    return viewer->web_context;
+}
+
+static NoticePopup*
+gooroom_notice_popup_new (GooroomNoticeViewer *viewer)
+{
+    NoticePopup *popup;
+    popup = g_new0 (NoticePopup, 1);
+
+    GtkWidget *window;
+
+    window = gtk_window_new (GTK_WINDOW_TOPLEVEL);
+    gtk_container_set_border_width (GTK_CONTAINER (window), 5);
+    gtk_window_set_type_hint (GTK_WINDOW (window), GDK_WINDOW_TYPE_HINT_DIALOG);
+    gtk_window_set_skip_taskbar_hint (GTK_WINDOW (window), TRUE);
+    gtk_window_set_position (GTK_WINDOW (window), GTK_WIN_POS_CENTER);
+    gtk_window_set_title (GTK_WINDOW (window), _("Notice"));
+
+    GtkWidget *main_vbox = gtk_box_new (GTK_ORIENTATION_VERTICAL, 5);
+    gtk_container_add (GTK_CONTAINER (window), main_vbox);
+    gtk_widget_show (main_vbox);
+
+    GtkWidget *scroll_window = gtk_scrolled_window_new (NULL, NULL);
+    gtk_scrolled_window_set_policy (GTK_SCROLLED_WINDOW (scroll_window), GTK_POLICY_AUTOMATIC, GTK_POLICY_AUTOMATIC);
+    gtk_box_pack_start (GTK_BOX (main_vbox), scroll_window, TRUE, TRUE, 0);
+    gtk_widget_show (scroll_window);
+
+    WebKitWebView *view = WEBKIT_WEB_VIEW (webkit_web_view_new_with_context (gooroom_notice_web_context_get (viewer)));
+    gtk_container_add (GTK_CONTAINER (scroll_window), GTK_WIDGET(view));
+    gtk_widget_show (GTK_WIDGET(view));
+
+    g_signal_connect (window, "delete-event", G_CALLBACK (on_notification_popup_delete_cb), viewer);
+    g_signal_connect (view, "close", G_CALLBACK (on_notification_popup_webview_closed), viewer);
+    g_signal_connect (view, "load-changed", G_CALLBACK (on_notification_popup_load_changed), viewer);
+    g_signal_connect (view, "load-failed", G_CALLBACK (on_notification_popup_load_failed), viewer);
+    g_signal_connect (view, "resource-load-started", G_CALLBACK (on_notification_popup_resource_started), viewer);
+    g_object_set_data (G_OBJECT (view), "notice-popup", popup);
+    g_object_set_data (G_OBJECT (view), "notice-viewer", viewer);
+
+    GtkWidget *hbox = gtk_box_new (GTK_ORIENTATION_HORIZONTAL, 0);
+    gtk_box_pack_end (GTK_BOX (main_vbox), hbox, FALSE, TRUE, 0);
+    gtk_widget_show (hbox);
+
+    GtkWidget *button = gtk_button_new_with_label (_("Close"));
+    gtk_widget_set_can_focus (button, TRUE);
+    gtk_box_pack_end (GTK_BOX (hbox), button, FALSE, FALSE, 0);
+    g_signal_connect (G_OBJECT (button), "clicked", G_CALLBACK (on_notification_popup_closed), viewer);
+    gtk_widget_show (button);
+
+    gtk_window_set_default_size (GTK_WINDOW (window), 600, 550);
+
+    /* spawn the web process now so that the first notice does not pay for it */
+    webkit_web_view_load_uri (view, "about:blank");
+
+    popup->window = window;
+    popup->view = view;
+
+    return popup;
+}
+
+static gboolean
+gooroom_notice_popup_pool_fill (gpointer user_data)
+{
+    g_return_val_if_fail (user_data != NULL, FALSE);
+
+    GooroomNoticeViewer *viewer = (GooroomNoticeViewer *)user_data;
+
+    if (NOTICE_POPUP_POOL_SIZE <= g_queue_get_length (viewer->popup_pool))
+        return FALSE;
+
+    g_queue_push_tail (viewer->popup_pool, gooroom_notice_popup_new (viewer));
+
+    return (g_queue_get_length (viewer->popup_pool) < NOTICE_POPUP_POOL_SIZE);
+}
+
+static void
+gooroom_notice_popup_pool_refill (GooroomNoticeViewer *viewer)
+{
+    g_idle_add_full (G_PRIORITY_LOW, (GSourceFunc) gooroom_notice_popup_pool_fill, viewer, NULL);
+}
+
+static void
+gooroom_notice_popup_set_cookies (GooroomNoticeViewer *viewer, const gchar *url, const GooroomNoticeSession *session, gboolean prefetch)
+{
+    SoupURI *uri = url ? soup_uri_new (url) : NULL;
+    if (!uri || !uri->host)
+    {
+        if (uri)
+            soup_uri_free (uri);
+
+        gooroom_notice_popup_cookies_ready (viewer, url, viewer->popup_serial, prefetch);
+        return;
+    }
+
+    g_autofree gchar *lang = gooroom_notice_get_language ();
+
+    gchar *keys[] = { "CLIENT_ID", "SESSION_ID", "SIGNING", "LANG_CODE" };
+    const gchar *values[] = { session->client_id, session->session_id, session->signing, lang };
+
+    CookieBatch *batch;
+    batch = g_new0 (CookieBatch, 1);
+    batch->viewer = viewer;
+    batch->url = g_strdup (url);
+    batch->serial = viewer->popup_serial;
+    batch->pending = 1;
+    batch->prefetch = prefetch;
+
+    WebKitCookieManager *manager = webkit_web_context_get_cookie_manager (gooroom_notice_web_context_get (viewer));
+
+    guint i;
+    for (i = 0; i < G_N_ELEMENTS (keys); i++)
+    {
+        if (!values[i] || g_utf8_strlen (values[i], -1) == 0)
+            continue;
+
+        batch->pending++;
+        gooroom_notice_add_cookie (manager, keys[i], (gchar *)values[i], uri->host, on_notification_popup_cookie_cb, batch);
+    }
+    soup_uri_free (uri);
+
+    /* drop the guard reference; loads right away when no cookie was queued */
+    if (--batch->pending == 0)
+    {
+        gooroom_notice_popup_cookies_ready (viewer, batch->url, batch->serial, batch->prefetch);
+        g_free (batch->url);
+        g_free (batch);
+    }
+}
+
+static void
+gooroom_notice_prefetch_free (NoticePrefetch *prefetch)
+{
+    g_free (prefetch->url);
+    g_free (prefetch->client_id);
+    g_free (prefetch->session_id);
+    g_free (prefetch->signing);
+    g_free (prefetch);
+}
+
+/* the oldest prefetch that is no longer loading */
+static NoticePopup*
+gooroom_notice_prefetch_oldest_idle (GooroomNoticeViewer *viewer)
+{
+    GList *l;
+
+    for (l = viewer->prefetched->head; l; l = l->next)
+    {
+        NoticePopup *popup = l->data;
+        if (!popup->prefetch_loading)
+            return popup;
+    }
+    return NULL;
+}
+
+static void
+gooroom_notice_prefetch_start (GooroomNoticeViewer *viewer, NoticePrefetch *prefetch)
+{
+    NoticePopup *popup = g_queue_pop_head (viewer->popup_pool);
+    if (popup == NULL)
+        popup = gooroom_notice_popup_new (viewer);
+
+    gooroom_notice_popup_pool_refill (viewer);
+
+    popup->prefetch_url = g_strdup (prefetch->url);
+    popup->prefetch_loading = TRUE;
+    g_queue_push_tail (viewer->prefetched, popup);
+
+    gooroom_notice_stats_count (viewer->stats, GOOROOM_NOTICE_COUNTER_PREFETCHES, 1);
+
+    GooroomNoticeSession session = { prefetch->client_id, prefetch->session_id, prefetch->signing };
+    gooroom_notice_popup_set_cookies (viewer, prefetch->url, &session, TRUE);
+}
+
+static gboolean
+gooroom_notice_prefetch_run (gpointer user_data)
+{
+    GooroomNoticeViewer *viewer = (GooroomNoticeViewer *)user_data;
+    NoticePopup *oldest;
+
+    viewer->prefetch_id = 0;
+
+    while (!g_queue_is_empty (viewer->prefetch_pending))
+    {
+        /* make room by dropping the oldest finished pages; loads in flight are left alone */
+        while ((viewer->prefetch_limit <= g_queue_get_length (viewer->prefetched) ||
+                viewer->prefetch_budget <= viewer->prefetch_bytes) &&
+               (oldest = gooroom_notice_prefetch_oldest_idle (viewer)))
+            gooroom_notice_popup_recycle (viewer, oldest);
+
+        if (viewer->prefetch_limit <= g_queue_get_length (viewer->prefetched) ||
+            viewer->prefetch_budget <= viewer->prefetch_bytes)
+            break;
+
+        NoticePrefetch *prefetch = g_queue_pop_head (viewer->prefetch_pending);
+        gooroom_notice_prefetch_start (viewer, prefetch);
+        gooroom_notice_prefetch_free (prefetch);
+    }
+
+    return FALSE;
+}
+
+static void
+gooroom_notice_prefetch_schedule (GooroomNoticeViewer *viewer)
+{
+    if (viewer->prefetch_id || g_queue_is_empty (viewer->prefetch_pending))
+        return;
+
+    viewer->prefetch_id = g_idle_add_full (G_PRIORITY_LOW, gooroom_notice_prefetch_run, viewer, NULL);
+}
+
+static gboolean
+gooroom_notice_prefetch_pending (GooroomNoticeViewer *viewer, const gchar *url)
+{
+    GList *l;
+
+    for (l = viewer->prefetch_pending->head; l; l = l->next)
+    {
+        if (g_strcmp0 (((NoticePrefetch *)l->data)->url, url) == 0)
+            return TRUE;
+    }
+    return FALSE;
+}
+
+static void
+gooroom_notice_viewer_prefetch (GooroomNoticeViewer *viewer, const gchar *url, const GooroomNoticeSession *session)
+{
+    if (!url || viewer->prefetch_limit == 0)
+        return;
+
+    if (!g_network_monitor_get_network_available (g_network_monitor_get_default ()))
+        return;
+
+    if (gooroom_notice_prefetch_find (viewer, url) || gooroom_notice_prefetch_pending (viewer, url))
+        return;
+
+    /* only the newest notices are worth warming up */
+    while (viewer->prefetch_limit <= g_queue_get_length (viewer->prefetch_pending))
+        gooroom_notice_prefetch_free (g_queue_pop_head (viewer->prefetch_pending));
+
+    NoticePrefetch *prefetch = g_new0 (NoticePrefetch, 1);
+    prefetch->url = g_strdup (url);
+    prefetch->client_id = g_strdup (session->client_id);
+    prefetch->session_id = g_strdup (session->session_id);
+    prefetch->signing = g_strdup (session->signing);
+    g_queue_push_tail (viewer->prefetch_pending, prefetch);
+
+    gooroom_notice_prefetch_schedule (viewer);
+    gooroom_notice_viewer_touch (viewer);
+}
+
+static void
+gooroom_notice_viewer_open (GooroomNoticeViewer *viewer, const gchar *url, const GooroomNoticeSession *session)
+{
+    /* a prefetched page becomes the popup as it is */
+    NoticePopup *hit = url ? gooroom_notice_prefetch_find (viewer, url) : NULL;
+    if (hit)
+    {
+        gboolean warm = hit->prefetch_started && !hit->prefetch_cut;
+
+        gooroom_notice_popup_release (viewer);
+        gooroom_notice_prefetch_forget (viewer, hit);
+        viewer->popup = hit;
+        viewer->popup_serial++;
+        hit->url = g_strdup (url);
+
+        gooroom_notice_stats_count (viewer->stats, GOOROOM_NOTICE_COUNTER_PREFETCH_HITS, 1);
+
+        if (!warm)
+            gooroom_notice_popup_set_cookies (viewer, url, session, FALSE);
+
+        gooroom_notice_prefetch_schedule (viewer);
+        gooroom_notice_viewer_touch (viewer);
+
+        gtk_widget_grab_focus (GTK_WIDGET (hit->view));
+        gtk_window_present (GTK_WINDOW (hit->window));
+        return;
+    }
+
+    if (viewer->popup == NULL)
+    {
+        viewer->popup = g_queue_pop_head (viewer->popup_pool);
+        if (viewer->popup == NULL)
+            viewer->popup = gooroom_notice_popup_new (viewer);
+
+        gooroom_notice_popup_pool_refill (viewer);
+    }
+
+    NoticePopup *popup = viewer->popup;
+    viewer->popup_serial++;
+
+    g_free (popup->url);
+    popup->url = g_strdup (url);
+    g_free (popup->saved);
+    popup->saved = url ? gooroom_notice_pages_lookup (viewer->pages, url) : NULL;
+    popup->saved_shown = FALSE;
+    popup->live_ready = FALSE;
+
+    /* the saved copy shows at once; the live page replaces it unless it fails to load */
+    if (popup->saved)
+        gooroom_notice_popup_load (viewer, popup->saved);
+
+    gooroom_notice_popup_set_cookies (viewer, url, session, FALSE);
+    gooroom_notice_viewer_touch (viewer);
+
+    gtk_widget_grab_focus (GTK_WIDGET (popup->view));
+    gtk_window_present (GTK_WINDOW (popup->window));
+}
+
+/*
+ * Unclicked prefetches and the spare popups keep the web process alive;
+ * with their views gone it exits. The memory cache goes with them.
+ */
+static void
+gooroom_notice_viewer_reclaim (gpointer user_data)
+{
+    GooroomNoticeViewer *viewer = (GooroomNoticeViewer *)user_data;
+    NoticePopup *popup;
+
+    while ((popup = gooroom_notice_prefetch_oldest_idle (viewer)))
+        gooroom_notice_popup_recycle (viewer, popup);
+
+    while ((popup = g_queue_pop_head (viewer->popup_pool)))
+    {
+        gtk_widget_destroy (popup->window);
+        g_free (popup);
+    }
+
+    if (viewer->web_context)
+    {
+        WebKitWebsiteDataManager *manager = webkit_web_context_get_website_data_manager (viewer->web_context);
+        webkit_website_data_manager_clear (manager, WEBKIT_WEBSITE_DATA_MEMORY_CACHE, 0, NULL, NULL, NULL);
+    }
+}
+
+static const gchar introspection_xml[] =
+    "<node>"
+    "  <interface name='" NOTICE_VIEWER_INTERFACE "'>"
+    "    <method name='Open'>"
+    "      <arg type='s' name='url' direction='in'/>"
+    "      <arg type='s' name='client_id' direction='in'/>"
+    "      <arg type='s' name='session_id' direction='in'/>"
+    "      <arg type='s' name='signing' direction='in'/>"
+    "    </method>"
+    "    <method name='Prefetch'>"
+    "      <arg type='s' name='url' direction='in'/>"
+    "      <arg type='s' name='client_id' direction='in'/>"
+    "      <arg type='s' name='session_id' direction='in'/>"
+    "      <arg type='s' name='signing' direction='in'/>"
+    "    </method>"
+    "  </interface>"
+    "</node>";
+
+static void
+gooroom_notice_viewer_method_call (GDBusConnection *connection,
+                                   const gchar *sender,
+                                   const gchar *object_path,
+                                   const gchar *interface_name,
+                                   const gchar *method_name,
+                                   GVariant *parameters,
+                                   GDBusMethodInvocation *invocation,
+                                   gpointer user_data)
+{
+    GooroomNoticeViewer *viewer = (GooroomNoticeViewer *)user_data;
+    const gchar *url, *client_id, *session_id, *signing;
+
+    g_variant_get (parameters, "(&s&s&s&s)", &url, &client_id, &session_id, &signing);
+
+    /* empty strings stand in for what D-Bus cannot carry as NULL */
+    GooroomNoticeSession session = { client_id, session_id, signing };
+    if (*url == '\0')
+        url = NULL;
+
+    if (g_strcmp0 (method_name, "Open") == 0)
+    {
+        gooroom_notice_viewer_open (viewer, url, &session);
+    }
+    else if (g_strcmp0 (method_name, "Prefetch") == 0)
+    {
+        gooroom_notice_viewer_prefetch (viewer, url, &session);
+    }
+    else
+    {
+        g_dbus_method_invocation_return_error (invocation, G_DBUS_ERROR, G_DBUS_ERROR_UNKNOWN_METHOD,
+                "Unknown method %s", method_name);
+        return;
+    }
+
+    g_dbus_method_invocation_return_value (invocation, NULL);
+}
+
+static const GDBusInterfaceVTable viewer_vtable =
+{
+    gooroom_notice_viewer_method_call,
+    NULL,
+    NULL
+};
+
+static void
+on_notice_viewer_bus_acquired (GDBusConnection *connection, const gchar *name, gpointer user_data)
+{
+    GooroomNoticeViewer *viewer = (GooroomNoticeViewer *)user_data;
+    GError *error = NULL;
+
+    GDBusNodeInfo *node = g_dbus_node_info_new_for_xml (introspection_xml, &error);
+    if (node)
+    {
+        g_dbus_connection_register_object (connection, NOTICE_VIEWER_PATH,
+                node->interfaces[0], &viewer_vtable, viewer, NULL, &error);
+        g_dbus_node_info_unref (node);
+    }
+
+    if (!error)
+        gooroom_notice_stats_export (viewer->stats, connection, NOTICE_VIEWER_PATH, &error);
+
+    if (error)
+    {
+        g_warning ("on_notice_viewer_bus_acquired : %s\n", error->message);
+        g_error_free (error);
+    }
+}
+
+/* another process holds the name, or the bus went away */
+static void
+on_notice_viewer_name_lost (GDBusConnection *connection, const gchar *name, gpointer user_data)
+{
+    g_debug ("on_notice_viewer_name_lost : %s\n", name);
+
+    gtk_main_quit ();
+}
+
+int
+main (int argc, char **argv)
+{
+    GError *error = NULL;
+
+    bindtextdomain (GETTEXT_PACKAGE, LOCALEDIR);
+    bind_textdomain_codeset (GETTEXT_PACKAGE, "UTF-8");
+    textdomain (GETTEXT_PACKAGE);
+
+    if (!gtk_init_with_args (&argc, &argv, NULL, entries, GETTEXT_PACKAGE, &error))
+    {
+        g_printerr ("%s\n", error->message);
+        g_error_free (error);
+        return 1;
+    }
+
+    gooroom_notice_log_open (NOTICE_LOG_FILE, log_level, NOTICE_LOG_FILE_SIZE * 1024, NOTICE_LOG_FILES);
+    g_log_set_handler (NULL, G_LOG_LEVEL_MASK | G_LOG_FLAG_FATAL | G_LOG_FLAG_RECURSION,
+            gooroom_notice_log_handler, NULL);
+
+    GooroomNoticeViewer *viewer = g_new0 (GooroomNoticeViewer, 1);
+    viewer->stats = gooroom_notice_stats_new (NULL, NULL);
+    viewer->popup_pool = g_queue_new ();
+    viewer->prefetched = g_queue_new ();
+    viewer->prefetch_pending = g_queue_new ();
+    viewer->prefetch_limit = MAX (prefetch_concurrency, 0);
+    viewer->prefetch_budget = (guint64)MAX (prefetch_budget, 0) * 1024;
+    viewer->disk_cache_size = (guint64)MAX (disk_cache, 0) * 1024 * 1024;
+    viewer->idle_timeout = MAX (idle_timeout, 1);
+    viewer->reclaim = gooroom_notice_reclaim_new (MAX (reclaim_delay, 0), viewer->stats, gooroom_notice_viewer_reclaim, viewer);
+
+    g_autofree gchar *pages_dir = g_build_filename (g_get_user_cache_dir (), PACKAGE_NAME, "pages", NULL);
+    viewer->pages = gooroom_notice_pages_new (pages_dir, (guint64)MAX (offline_cache, 0) * 1024 * 1024);
+
+    gooroom_notice_popup_pool_refill (viewer);
+    gooroom_notice_viewer_touch (viewer);
+
+    /* the name carries the agent session, so it is neither handed over nor taken */
+    viewer->owner_id = g_bus_own_name (G_BUS_TYPE_SESSION,
+            NOTICE_VIEWER_BUS_NAME,
+            G_BUS_NAME_OWNER_FLAGS_NONE,
+            on_notice_viewer_bus_acquired,
+            NULL,
+            on_notice_viewer_name_lost,
+            viewer,
+            NULL);
+
+    gtk_main ();
+
+    if (viewer->owner_id)
+        g_bus_unown_name (viewer->owner_id);
+    gooroom_notice_pages_free (viewer->pages);
+    gooroom_notice_log_close ();
+
+    return 0;
+}
@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2018-2019 Gooroom <gooroom@gooroom.kr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#ifndef __GOOROOM_NOTICE_VIEWER_H__
+#define __GOOROOM_NOTICE_VIEWER_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/*
+ * The notice popup runs in gooroom-notice-viewer, a helper the applet
+ * starts on first use so that the tray process never loads WebKit. The
+ * viewer owns NOTICE_VIEWER_BUS_NAME on the session bus and exports
+ *
+ *   Open (s url, s client_id, s session_id, s signing)
+ *   Prefetch (s url, s client_id, s session_id, s signing)
+ *
+ * on NOTICE_VIEWER_INTERFACE, next to its stats, at NOTICE_VIEWER_PATH.
+ * Empty strings stand for missing values. Once nothing has been on
+ * screen or loading for --idle-timeout seconds it releases the name and
+ * exits; the applet starts it again on the next call. The name is never
+ * replaced, and the applet only sends calls to an owner running the
+ * installed viewer binary.
+ */
+#define NOTICE_VIEWER_BUS_NAME    "kr.gooroom.noticeviewer"
+#define NOTICE_VIEWER_PATH        "/kr/gooroom/noticeviewer"
+#define NOTICE_VIEWER_INTERFACE   "kr.gooroom.noticeviewer"
+#define NOTICE_VIEWER_PROGRAM     "gooroom-notice-viewer"
+
+/* defaults for the options the applet passes from its configuration */
+#define NOTICE_VIEWER_IDLE_TIMEOUT          (300)
+#define NOTICE_VIEWER_DISK_CACHE_SIZE       (50)
+#define NOTICE_VIEWER_PREFETCH_CONCURRENCY  (2)
+#define NOTICE_VIEWER_PREFETCH_BUDGET       (4096)
+#define NOTICE_VIEWER_OFFLINE_CACHE_SIZE    (20)
+#define NOTICE_VIEWER_RECLAIM_DELAY         (60)
+
+G_END_DECLS
+
+#endif /* __GOOROOM_NOTICE_VIEWER_H__*/
@@ -0,0 +1,48 @@
+#!/bin/sh
+#
+# Runs gooroom-notice-applet against gooroom-agent-standin on a private
+# dbus-daemon and prints the stand-in's latency report. Arguments are
+# passed to the stand-in, e.g.
+#
+#   gooroom-agent-load.sh --rate 50 --burst 20 --size 5 --bursts 200
+#
+# Without a display the applet is started under xvfb-run when available.
+
+set -e
+
+here=$(cd "$(dirname "$0")" && pwd)
+applet=${APPLET:-$here/../src/gooroom-notice-applet}
+standin=${STANDIN:-$here/gooroom-agent-standin}
+
+state=$(mktemp -d -t gooroom-agent-load.XXXXXX)
+
+bus=$(dbus-daemon --config-file="$here/agent-bus.conf" --fork --print-address=1 --print-pid=1)
+address=$(echo "$bus" | sed -n 1p)
+bus_pid=$(echo "$bus" | sed -n 2p)
+
+cleanup () {
+    [ -n "$applet_pid" ] && kill "$applet_pid" 2>/dev/null || true
+    kill "$bus_pid" 2>/dev/null || true
+    rm -rf "$state"
+}
+trap cleanup EXIT INT TERM
+
+export DBUS_SYSTEM_BUS_ADDRESS="$address"
+export DBUS_SESSION_BUS_ADDRESS="$address"
+export XDG_CACHE_HOME="$state/cache"
+export XDG_DATA_HOME="$state/data"
+
+"$standin" "$@" &
+standin_pid=$!
+
+# give the stand-in time to claim its names before the applet looks for them
+sleep 0.5
+
+if [ -z "$DISPLAY" ] && command -v xvfb-run >/dev/null 2>&1; then
+    xvfb-run -a "$applet" &
+else
+    "$applet" &
+fi
+applet_pid=$!
+
+wait "$standin_pid"
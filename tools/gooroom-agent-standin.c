@@ -0,0 +1,638 @@
+/*
+ * Copyright (c) 2018 - 2019 Gooroom <gooroom@gooroom.kr>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+/*
+ * Stand-in for the Gooroom agent on a private bus. It answers the
+ * applet's get_noti request, floods it with set_noti signals, and also
+ * plays notification daemon and status notifier watcher so that it can
+ * see when each signal reaches the screen.
+ *
+ * The notices of every signal stay on the stand-in's board, so they are
+ * listed again by later get_noti replies. A get_noti carrying a cursor
+ * from this run is answered with a delta: notices posted since, and
+ * retracted_notis for those that dropped off the board (--keep).
+ * --reappear makes the applet sync again every N bursts.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+#include <gio/gio.h>
+
+static gint      bursts = 100;
+static gint      burst = 1;
+static gint      size = 1;
+static gint      initial = 0;
+static gint      title_bytes = 0;
+static gint      display = 0;
+static gint      settle = 3000;
+static gint      wait_timeout = 30000;
+static gint      keep = 0;
+static gint      reappear = 0;
+static gdouble   rate = 10;
+
+static GOptionEntry entries[] =
+{
+    { "bursts", 'n', 0, G_OPTION_ARG_INT, &bursts, "Number of bursts to emit", "N" },
+    { "rate", 'r', 0, G_OPTION_ARG_DOUBLE, &rate, "Bursts per second", "R" },
+    { "burst", 'b', 0, G_OPTION_ARG_INT, &burst, "set_noti signals per burst", "B" },
+    { "size", 's', 0, G_OPTION_ARG_INT, &size, "Notices per signal", "S" },
+    { "title-bytes", 0, 0, G_OPTION_ARG_INT, &title_bytes, "Padding added to each title", "BYTES" },
+    { "initial", 'i', 0, G_OPTION_ARG_INT, &initial, "Notices in the get_noti reply", "N" },
+    { "display", 0, 0, G_OPTION_ARG_INT, &display, "Milliseconds a notification stays on screen", "MS" },
+    { "settle", 0, 0, G_OPTION_ARG_INT, &settle, "Milliseconds to wait after the last burst", "MS" },
+    { "wait-timeout", 0, 0, G_OPTION_ARG_INT, &wait_timeout, "Milliseconds to wait for the applet", "MS" },
+    { "keep", 0, 0, G_OPTION_ARG_INT, &keep, "Signals kept on the board, older ones are retracted (0: all)", "N" },
+    { "reappear", 0, 0, G_OPTION_ARG_INT, &reappear, "Re-own the agent name every N bursts (0: never)", "N" },
+    { NULL }
+};
+
+static const gchar introspection_xml[] =
+    "<node>"
+    "  <interface name='kr.gooroom.agent'>"
+    "    <method name='do_task'>"
+    "      <arg type='s' name='arg' direction='in'/>"
+    "      <arg type='v' name='result' direction='out'/>"
+    "    </method>"
+    "    <signal name='set_noti'>"
+    "      <arg type='v' name='noti'/>"
+    "    </signal>"
+    "  </interface>"
+    "  <interface name='org.freedesktop.Notifications'>"
+    "    <method name='Notify'>"
+    "      <arg type='s' direction='in'/>"
+    "      <arg type='u' direction='in'/>"
+    "      <arg type='s' direction='in'/>"
+    "      <arg type='s' direction='in'/>"
+    "      <arg type='s' direction='in'/>"
+    "      <arg type='as' direction='in'/>"
+    "      <arg type='a{sv}' direction='in'/>"
+    "      <arg type='i' direction='in'/>"
+    "      <arg type='u' direction='out'/>"
+    "    </method>"
+    "    <method name='CloseNotification'>"
+    "      <arg type='u' direction='in'/>"
+    "    </method>"
+    "    <method name='GetCapabilities'>"
+    "      <arg type='as' direction='out'/>"
+    "    </method>"
+    "    <method name='GetServerInformation'>"
+    "      <arg type='s' direction='out'/>"
+    "      <arg type='s' direction='out'/>"
+    "      <arg type='s' direction='out'/>"
+    "      <arg type='s' direction='out'/>"
+    "    </method>"
+    "    <signal name='NotificationClosed'>"
+    "      <arg type='u'/>"
+    "      <arg type='u'/>"
+    "    </signal>"
+    "  </interface>"
+    "  <interface name='org.kde.StatusNotifierWatcher'>"
+    "    <method name='RegisterStatusNotifierItem'>"
+    "      <arg type='s' direction='in'/>"
+    "    </method>"
+    "    <method name='RegisterStatusNotifierHost'>"
+    "      <arg type='s' direction='in'/>"
+    "    </method>"
+    "    <property name='RegisteredStatusNotifierItems' type='as' access='read'/>"
+    "    <property name='IsStatusNotifierHostRegistered' type='b' access='read'/>"
+    "    <property name='ProtocolVersion' type='i' access='read'/>"
+    "  </interface>"
+    "</node>";
+
+typedef struct
+{
+    guint   seq;
+    gint64  sent;
+}Burst;
+
+typedef struct
+{
+    GMainLoop       *loop;
+    GDBusConnection *bus;
+    GDBusNodeInfo   *node;
+
+    gboolean  started;
+    guint     epoch;
+    guint     seq;
+    guint     ticks;
+    guint     notice_id;
+    guint     emitted;
+    gsize     emitted_bytes;
+
+    GQueue   *pending;
+    GArray   *latency;
+    guint     requests;
+    guint     full_replies;
+    guint     delta_replies;
+    gsize     reply_bytes;
+    guint     notified;
+    guint     status_updates;
+    gchar    *item;
+}Standin;
+
+static void
+standin_append_notis (GString *str, const gchar *prefix, guint seq, gint count)
+{
+    gint i;
+
+    for (i = 0; i < count; i++)
+    {
+        if (str->str[str->len - 1] != '[')
+            g_string_append_c (str, ',');
+
+        g_string_append_printf (str, "{\"noti_id\":\"%s%u-%d\",\"title\":\"%s%u ",
+                prefix, seq, i, *prefix ? prefix : "#", seq);
+        gint pad;
+        for (pad = 0; pad < title_bytes; pad++)
+            g_string_append_c (str, 'x');
+        g_string_append_printf (str, "\",\"url\":\"http://localhost/notice/%s%u-%d\"}", prefix, seq, i);
+    }
+}
+
+static void
+standin_append_tail (GString *str)
+{
+    g_string_append (str, ",\"disabled_title_view_cnt\":0,\"signing\":\"c2lnbmluZw==\","
+                          "\"client_id\":\"standin-client\",\"session_id\":\"standin-session\","
+                          "\"default_noti_domain\":\"http://localhost/notice\"}");
+}
+
+static gchar*
+standin_noti_info (const gchar *prefix, guint seq, gint count)
+{
+    GString *str = g_string_sized_new (count * (title_bytes + 96) + 256);
+
+    g_string_append (str, "{\"enabled_title_view_notis\":[");
+    standin_append_notis (str, prefix, seq, count);
+    g_string_append_c (str, ']');
+    standin_append_tail (str);
+
+    return g_string_free (str, FALSE);
+}
+
+/* signals up to this one have dropped off the board at revision @seq */
+static guint
+standin_board_oldest (guint seq)
+{
+    return (0 < keep && (guint)keep < seq) ? seq - keep : 0;
+}
+
+static gchar*
+standin_get_noti_reply (Standin *standin, const gchar *arg)
+{
+    const gchar *cursor = strstr (arg, "\"cursor\":\"");
+    guint epoch = 0, rev = 0;
+    guint oldest = standin_board_oldest (standin->seq);
+    guint s;
+
+    /* a cursor from another run or from the future is unknown: full sync */
+    gboolean delta = (cursor &&
+                      sscanf (cursor + strlen ("\"cursor\":\""), "%x:%u", &epoch, &rev) == 2 &&
+                      epoch == standin->epoch &&
+                      rev <= standin->seq);
+
+    GString *str = g_string_sized_new (4096);
+
+    g_string_append (str, "{\"module\":{\"module_name\":\"noti\",\"task\":{\"task_name\":\"get_noti\","
+                          "\"out\":{\"status\":\"200\",\"noti_info\":{\"enabled_title_view_notis\":[");
+
+    if (!delta)
+        standin_append_notis (str, "init-", 0, initial);
+
+    for (s = MAX (delta ? rev : 0, oldest) + 1; s <= standin->seq; s++)
+        standin_append_notis (str, "", s, size);
+
+    g_string_append_c (str, ']');
+
+    if (delta)
+    {
+        g_string_append (str, ",\"retracted_notis\":[");
+        for (s = standin_board_oldest (rev) + 1; s <= oldest; s++)
+        {
+            gint i;
+            for (i = 0; i < size; i++)
+                g_string_append_printf (str, "%s\"%u-%d\"", (str->str[str->len - 1] == '[') ? "" : ",", s, i);
+        }
+        g_string_append_c (str, ']');
+    }
+
+    g_string_append_printf (str, ",\"sync\":\"%s\",\"cursor\":\"%08x:%u\"",
+            delta ? "delta" : "full", standin->epoch, standin->seq);
+    standin_append_tail (str);
+    g_string_append (str, "}}}}");
+
+    if (delta)
+        standin->delta_replies++;
+    else
+        standin->full_replies++;
+    standin->reply_bytes += str->len;
+
+    return g_string_free (str, FALSE);
+}
+
+/* the first screen update after a signal closes its measurement */
+static void
+standin_resolve (Standin *standin, gint64 seq)
+{
+    GList *l = standin->pending->head;
+
+    if (0 <= seq)
+    {
+        for (; l; l = l->next)
+            if (((Burst *)l->data)->seq == (guint)seq)
+                break;
+
+        /* already measured, or listed again by a get_noti reply */
+        if (!l)
+            return;
+    }
+    else
+    {
+        /* digests and indicator updates cannot be told apart; they count for the oldest */
+        l = standin->pending->head;
+    }
+
+    if (!l)
+        return;
+
+    Burst *b = l->data;
+    gint64 latency = g_get_monotonic_time () - b->sent;
+
+    g_array_append_val (standin->latency, latency);
+    g_queue_delete_link (standin->pending, l);
+    g_free (b);
+}
+
+static gboolean
+standin_quit (gpointer user_data)
+{
+    g_main_loop_quit (((Standin *)user_data)->loop);
+    return FALSE;
+}
+
+static gboolean standin_own (GDBusConnection *bus, const gchar *name);
+
+static gboolean
+standin_emit (gpointer user_data)
+{
+    Standin *standin = (Standin *)user_data;
+    gint i;
+
+    for (i = 0; i < burst; i++)
+    {
+        guint seq = ++standin->seq;
+        g_autofree gchar *info = standin_noti_info ("", seq, size);
+
+        Burst *b = g_new0 (Burst, 1);
+        b->seq = seq;
+        b->sent = g_get_monotonic_time ();
+        g_queue_push_tail (standin->pending, b);
+
+        g_dbus_connection_emit_signal (standin->bus, NULL,
+                "/kr/gooroom/agent", "kr.gooroom.agent", "set_noti",
+                g_variant_new ("(v)", g_variant_new_string (info)),
+                NULL);
+
+        standin->emitted++;
+        standin->emitted_bytes += strlen (info);
+    }
+
+    /* the applet sees the agent vanish and come back, and syncs again */
+    if (0 < reappear && standin->ticks % reappear == reappear - 1)
+    {
+        g_dbus_connection_call_sync (standin->bus,
+                "org.freedesktop.DBus", "/org/freedesktop/DBus", "org.freedesktop.DBus",
+                "ReleaseName", g_variant_new ("(s)", "kr.gooroom.agent"),
+                NULL, G_DBUS_CALL_FLAGS_NONE, -1, NULL, NULL);
+        standin_own (standin->bus, "kr.gooroom.agent");
+    }
+
+    if (++standin->ticks < (guint)bursts)
+        return TRUE;
+
+    g_timeout_add (settle, standin_quit, standin);
+    return FALSE;
+}
+
+static void
+standin_start (Standin *standin)
+{
+    if (standin->started)
+        return;
+
+    standin->started = TRUE;
+    g_timeout_add (MAX ((guint)(1000 / rate), 1), standin_emit, standin);
+}
+
+typedef struct
+{
+    Standin *standin;
+    guint    id;
+}Closing;
+
+static gboolean
+standin_notification_expire (gpointer user_data)
+{
+    Closing *closing = (Closing *)user_data;
+
+    g_dbus_connection_emit_signal (closing->standin->bus, NULL,
+            "/org/freedesktop/Notifications", "org.freedesktop.Notifications", "NotificationClosed",
+            g_variant_new ("(uu)", closing->id, 1),
+            NULL);
+
+    g_free (closing);
+    return FALSE;
+}
+
+static void
+standin_method_call (GDBusConnection *connection,
+                     const gchar *sender,
+                     const gchar *object_path,
+                     const gchar *interface_name,
+                     const gchar *method_name,
+                     GVariant *parameters,
+                     GDBusMethodInvocation *invocation,
+                     gpointer user_data)
+{
+    Standin *standin = (Standin *)user_data;
+
+    if (g_strcmp0 (method_name, "do_task") == 0)
+    {
+        const gchar *arg;
+        g_variant_get (parameters, "(&s)", &arg);
+
+        if (!strstr (arg, "\"get_noti\""))
+        {
+            g_dbus_method_invocation_return_error (invocation, G_DBUS_ERROR, G_DBUS_ERROR_NOT_SUPPORTED, "unknown task");
+            return;
+        }
+
+        standin->requests++;
+
+        g_autofree gchar *reply = standin_get_noti_reply (standin, arg);
+        g_dbus_method_invocation_return_value (invocation, g_variant_new ("(v)", g_variant_new_string (reply)));
+
+        /* the applet is connected and listening */
+        standin_start (standin);
+    }
+    else if (g_strcmp0 (method_name, "Notify") == 0)
+    {
+        const gchar *summary;
+        g_variant_get (parameters, "(&su&s&s&s@as@a{sv}i)", NULL, NULL, NULL, &summary, NULL, NULL, NULL, NULL);
+
+        gint64 seq = -1;
+        if (summary[0] == '#')
+            seq = g_ascii_strtoll (summary + 1, NULL, 10);
+
+        /* notices of the get_noti reply are not part of the load */
+        standin->notified++;
+        if (!g_str_has_prefix (summary, "init-"))
+            standin_resolve (standin, seq);
+
+        Closing *closing = g_new0 (Closing, 1);
+        closing->standin = standin;
+        closing->id = ++standin->notice_id;
+
+        g_dbus_method_invocation_return_value (invocation, g_variant_new ("(u)", closing->id));
+        g_timeout_add (display, standin_notification_expire, closing);
+    }
+    else if (g_strcmp0 (method_name, "CloseNotification") == 0)
+    {
+        g_dbus_method_invocation_return_value (invocation, NULL);
+    }
+    else if (g_strcmp0 (method_name, "GetCapabilities") == 0)
+    {
+        const gchar *caps[] = { "actions", "body", NULL };
+        g_dbus_method_invocation_return_value (invocation, g_variant_new ("(^as)", caps));
+    }
+    else if (g_strcmp0 (method_name, "GetServerInformation") == 0)
+    {
+        g_dbus_method_invocation_return_value (invocation,
+                g_variant_new ("(ssss)", "gooroom-agent-standin", "Gooroom", "0.1", "1.2"));
+    }
+    else if (g_strcmp0 (method_name, "RegisterStatusNotifierItem") == 0)
+    {
+        const gchar *item;
+        g_variant_get (parameters, "(&s)", &item);
+
+        g_free (standin->item);
+        standin->item = g_strdup (item);
+        g_dbus_method_invocation_return_value (invocation, NULL);
+    }
+    else
+    {
+        g_dbus_method_invocation_return_value (invocation, NULL);
+    }
+}
+
+static GVariant*
+standin_get_property (GDBusConnection *connection,
+                      const gchar *sender,
+                      const gchar *object_path,
+                      const gchar *interface_name,
+                      const gchar *property_name,
+                      GError **error,
+                      gpointer user_data)
+{
+    Standin *standin = (Standin *)user_data;
+
+    if (g_strcmp0 (property_name, "IsStatusNotifierHostRegistered") == 0)
+        return g_variant_new_boolean (TRUE);
+
+    if (g_strcmp0 (property_name, "ProtocolVersion") == 0)
+        return g_variant_new_int32 (0);
+
+    const gchar *items[] = { standin->item, NULL };
+    return g_variant_new_strv (items, standin->item ? 1 : 0);
+}
+
+static const GDBusInterfaceVTable standin_vtable =
+{
+    standin_method_call,
+    standin_get_property,
+    NULL
+};
+
+static void
+on_status_changed (GDBusConnection *connection,
+                   const gchar *sender_name,
+                   const gchar *object_path,
+                   const gchar *interface_name,
+                   const gchar *signal_name,
+                   GVariant *parameters,
+                   gpointer user_data)
+{
+    Standin *standin = (Standin *)user_data;
+    const gchar *status;
+
+    g_variant_get (parameters, "(&s)", &status);
+
+    standin->status_updates++;
+    if (g_strcmp0 (status, "NeedsAttention") == 0)
+        standin_resolve (standin, -1);
+}
+
+static gboolean
+standin_wait_timeout (gpointer user_data)
+{
+    Standin *standin = (Standin *)user_data;
+
+    if (standin->started)
+        return FALSE;
+
+    g_printerr ("gooroom-agent-standin: no get_noti request from the applet\n");
+    g_main_loop_quit (standin->loop);
+    return FALSE;
+}
+
+static gint
+standin_compare (gconstpointer a, gconstpointer b)
+{
+    gint64 x = *(const gint64 *)a, y = *(const gint64 *)b;
+    return (x > y) - (x < y);
+}
+
+static gint64
+standin_percentile (GArray *samples, gdouble p)
+{
+    if (samples->len == 0)
+        return 0;
+
+    guint idx = (guint)(p * (samples->len - 1) + 0.5);
+    return g_array_index (samples, gint64, idx);
+}
+
+static gboolean
+standin_own (GDBusConnection *bus, const gchar *name)
+{
+    GError *error = NULL;
+    GVariant *ret = g_dbus_connection_call_sync (bus,
+            "org.freedesktop.DBus", "/org/freedesktop/DBus", "org.freedesktop.DBus",
+            "RequestName", g_variant_new ("(su)", name, 4 /* DO_NOT_QUEUE */),
+            G_VARIANT_TYPE ("(u)"), G_DBUS_CALL_FLAGS_NONE, -1, NULL, &error);
+
+    if (!ret)
+    {
+        g_printerr ("gooroom-agent-standin: %s: %s\n", name, error->message);
+        g_error_free (error);
+        return FALSE;
+    }
+
+    guint32 result;
+    g_variant_get (ret, "(u)", &result);
+    g_variant_unref (ret);
+
+    /* 1 == PRIMARY_OWNER */
+    if (result != 1)
+        g_printerr ("gooroom-agent-standin: %s is already owned\n", name);
+
+    return result == 1;
+}
+
+int
+main (int argc, char **argv)
+{
+    GError *error = NULL;
+    GOptionContext *context = g_option_context_new ("- stand-in Gooroom agent and load generator");
+    g_option_context_add_main_entries (context, entries, NULL);
+    if (!g_option_context_parse (context, &argc, &argv, &error))
+    {
+        g_printerr ("%s\n", error->message);
+        return 1;
+    }
+    g_option_context_free (context);
+
+    if (rate <= 0 || bursts < 1 || burst < 1 || size < 0 || keep < 0 || reappear < 0)
+    {
+        g_printerr ("gooroom-agent-standin: invalid load parameters\n");
+        return 1;
+    }
+
+    /* the applet uses the system bus for the agent and the session bus for the desktop */
+    const gchar *address = g_getenv ("DBUS_SYSTEM_BUS_ADDRESS");
+    if (!address)
+    {
+        g_printerr ("gooroom-agent-standin: DBUS_SYSTEM_BUS_ADDRESS must point at a private bus\n");
+        return 1;
+    }
+
+    Standin standin = { 0, };
+    standin.epoch = g_random_int ();
+    standin.bus = g_dbus_connection_new_for_address_sync (address,
+            G_DBUS_CONNECTION_FLAGS_AUTHENTICATION_CLIENT | G_DBUS_CONNECTION_FLAGS_MESSAGE_BUS_CONNECTION,
+            NULL, NULL, &error);
+    if (!standin.bus)
+    {
+        g_printerr ("gooroom-agent-standin: %s\n", error->message);
+        return 1;
+    }
+
+    standin.loop = g_main_loop_new (NULL, FALSE);
+    standin.pending = g_queue_new ();
+    standin.latency = g_array_new (FALSE, FALSE, sizeof (gint64));
+    standin.node = g_dbus_node_info_new_for_xml (introspection_xml, NULL);
+
+    g_dbus_connection_register_object (standin.bus, "/kr/gooroom/agent",
+            standin.node->interfaces[0], &standin_vtable, &standin, NULL, NULL);
+    g_dbus_connection_register_object (standin.bus, "/org/freedesktop/Notifications",
+            standin.node->interfaces[1], &standin_vtable, &standin, NULL, NULL);
+    g_dbus_connection_register_object (standin.bus, "/StatusNotifierWatcher",
+            standin.node->interfaces[2], &standin_vtable, &standin, NULL, NULL);
+
+    g_dbus_connection_signal_subscribe (standin.bus, NULL,
+            "org.kde.StatusNotifierItem", "NewStatus", NULL, NULL,
+            G_DBUS_SIGNAL_FLAGS_NONE, on_status_changed, &standin, NULL);
+
+    if (!standin_own (standin.bus, "kr.gooroom.agent") ||
+        !standin_own (standin.bus, "org.freedesktop.Notifications") ||
+        !standin_own (standin.bus, "org.kde.StatusNotifierWatcher"))
+        return 1;
+
+    g_timeout_add (wait_timeout, standin_wait_timeout, &standin);
+    g_main_loop_run (standin.loop);
+
+    g_array_sort (standin.latency, standin_compare);
+
+    printf ("{\"bursts\":%u,\"burst\":%d,\"size\":%d,\"rate\":%g,\"signals\":%u,\"signal_bytes\":%" G_GSIZE_FORMAT ","
+            "\"requests\":%u,\"full_replies\":%u,\"delta_replies\":%u,\"reply_bytes\":%" G_GSIZE_FORMAT ","
+            "\"notifications\":%u,\"status_updates\":%u,\"measured\":%u,\"unanswered\":%u,"
+            "\"latency_us\":{\"p50\":%" G_GINT64_FORMAT ",\"p90\":%" G_GINT64_FORMAT ","
+            "\"p99\":%" G_GINT64_FORMAT ",\"max\":%" G_GINT64_FORMAT "}}\n",
+            standin.ticks, burst, size, rate, standin.emitted, standin.emitted_bytes,
+            standin.requests, standin.full_replies, standin.delta_replies, standin.reply_bytes, standin.notified, standin.status_updates,
+            standin.latency->len, g_queue_get_length (standin.pending),
+            standin_percentile (standin.latency, 0.50), standin_percentile (standin.latency, 0.90),
+            standin_percentile (standin.latency, 0.99), standin_percentile (standin.latency, 1.0));
+
+    g_queue_free_full (standin.pending, g_free);
+    g_array_free (standin.latency, TRUE);
+    g_dbus_node_info_unref (standin.node);
+    g_object_unref (standin.bus);
+    g_main_loop_unref (standin.loop);
+    g_free (standin.item);
+
+    return standin.started ? 0 : 1;
+}
@@ -0,0 +1,125 @@
+#!/bin/sh
+#
+# Starts gooroom-notice-applet against gooroom-agent-standin on a private
+# dbus-daemon, cold and warm, and reports how long it takes from exec
+# until the indicator is shown and until the first notice is on screen.
+# The times come from the applet's GOOROOM_NOTICE_TRACE timeline.
+#
+#   gooroom-startup-bench.sh [RUNS]
+#
+# Cold runs start from an empty cache directory and, when run as root,
+# with the page cache dropped. Warm runs reuse the cache directory of a
+# first, unreported run, so that the applet restores its snapshot.
+# Without a display the applet is started under xvfb-run when available.
+
+set -e
+
+here=$(cd "$(dirname "$0")" && pwd)
+applet=${APPLET:-$here/../src/gooroom-notice-applet}
+standin=${STANDIN:-$here/gooroom-agent-standin}
+runs=${1:-5}
+
+state=$(mktemp -d -t gooroom-startup-bench.XXXXXX)
+
+cleanup () {
+    [ -n "$applet_pid" ] && kill "$applet_pid" 2>/dev/null || true
+    [ -n "$bus_pid" ] && kill "$bus_pid" 2>/dev/null || true
+    rm -rf "$state"
+}
+trap cleanup EXIT INT TERM
+
+# run CACHE TRACE: one applet start against a fresh bus and stand-in
+run () {
+    bus=$(dbus-daemon --config-file="$here/agent-bus.conf" --fork --print-address=1 --print-pid=1)
+    address=$(echo "$bus" | sed -n 1p)
+    bus_pid=$(echo "$bus" | sed -n 2p)
+
+    rm -f "$2"
+
+    DBUS_SYSTEM_BUS_ADDRESS="$address" \
+    DBUS_SESSION_BUS_ADDRESS="$address" \
+        "$standin" --initial 1 --bursts 1 --rate 1 --settle 1000 >/dev/null &
+    standin_pid=$!
+
+    # give the stand-in time to claim its names before the applet looks for them
+    sleep 0.5
+
+    export DBUS_SYSTEM_BUS_ADDRESS="$address"
+    export DBUS_SESSION_BUS_ADDRESS="$address"
+    export XDG_CACHE_HOME="$1/cache"
+    export XDG_DATA_HOME="$1/data"
+    export GOOROOM_NOTICE_TRACE="$2"
+
+    if [ -z "$DISPLAY" ] && command -v xvfb-run >/dev/null 2>&1; then
+        xvfb-run -a "$applet" &
+    else
+        "$applet" &
+    fi
+    applet_pid=$!
+
+    wait "$standin_pid" || true
+
+    kill "$applet_pid" 2>/dev/null || true
+    wait "$applet_pid" 2>/dev/null || true
+    applet_pid=
+
+    kill "$bus_pid" 2>/dev/null || true
+    bus_pid=
+}
+
+# mark TRACE NAME: milliseconds from exec to the applet's first NAME mark
+mark () {
+    [ -f "$1" ] || { printf '%s' -; return; }
+    awk -v name="$2" '
+        $3 == "main" && !pid { pid = $1 }
+        $1 == pid && $3 == name { printf "%.1f", $2 / 1000; found = 1; exit }
+        END { if (!found) printf "-" }' "$1"
+}
+
+report () {
+    sort -n | awk -v mode="$1" -v what="$2" '
+        $1 != "-" { v[n++] = $1 }
+        END {
+            if (!n) { printf "{\"mode\":\"%s\",\"%s\":null}\n", mode, what; exit }
+            printf "{\"mode\":\"%s\",\"%s\":{\"runs\":%d,\"min\":%.1f,\"p50\":%.1f,\"max\":%.1f}}\n",
+                   mode, what, n, v[0], v[int((n - 1) / 2)], v[n - 1]
+        }'
+}
+
+drop_caches () {
+    sync
+    [ -w /proc/sys/vm/drop_caches ] && echo 3 > /proc/sys/vm/drop_caches || true
+}
+
+[ -w /proc/sys/vm/drop_caches ] || echo "gooroom-startup-bench: not root, cold runs keep the page cache" >&2
+
+for mode in cold warm; do
+    : > "$state/$mode.indicator"
+    : > "$state/$mode.notice"
+
+    if [ "$mode" = warm ]; then
+        run "$state/warm" "$state/trace"
+    fi
+
+    i=0
+    while [ "$i" -lt "$runs" ]; do
+        i=$((i + 1))
+
+        if [ "$mode" = cold ]; then
+            rm -rf "$state/cold"
+            drop_caches
+        fi
+
+        run "$state/$mode" "$state/trace"
+
+        indicator=$(mark "$state/trace" indicator-shown)
+        notice=$(mark "$state/trace" notification-shown)
+        echo "$indicator" >> "$state/$mode.indicator"
+        echo "$notice" >> "$state/$mode.notice"
+
+        echo "gooroom-startup-bench: $mode $i: indicator ${indicator}ms, first notice ${notice}ms" >&2
+    done
+
+    report "$mode" time_to_indicator_ms < "$state/$mode.indicator"
+    report "$mode" time_to_first_notice_ms < "$state/$mode.notice"
+done